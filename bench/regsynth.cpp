@@ -0,0 +1,297 @@
+//
+// regsynth: writes a synthetic khronos style registry for scaling tests
+//
+// The output follows the subset of the registry schema that glbindify
+// reads: <types>, <enums>, <commands> with <proto>/<param>, <feature>
+// and <extensions>. Half of the commands and enums are required by
+// features and the rest are spread over the extensions. Everything is
+// deterministic so runs at the same size are directly comparable.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include "getopt.h"
+#else
+#include <getopt.h>
+#endif
+
+struct synth_params {
+	int commands;
+	int params;
+	int enums;
+	int features;
+	int extensions;
+};
+
+//Rough size of gl.xml, used as the unit for --scale
+static const synth_params g_gl_xml_size = { 3000, 3, 6000, 23, 700 };
+
+static const char *g_param_types[] = {
+	"GLenum", "GLuint", "GLint", "GLsizei", "GLfloat", "GLboolean", "GLbitfield", "GLdouble"
+};
+
+#define NUM_PARAM_TYPES (sizeof(g_param_types) / sizeof(g_param_types[0]))
+
+//Commands and enums the generated init function refers to directly
+static const char *g_required_commands[] = { "glGetIntegerv", "glGetStringi" };
+static const char *g_required_enums[] = { "GL_NUM_EXTENSIONS", "GL_MAJOR_VERSION", "GL_MINOR_VERSION", "GL_EXTENSIONS" };
+
+static void print_types(FILE *out)
+{
+	fprintf(out, "    <types>\n");
+	fprintf(out, "        <type name=\"stddef\">#include &lt;stddef.h&gt;</type>\n");
+	fprintf(out, "        <type>typedef unsigned int <name>GLenum</name>;</type>\n");
+	fprintf(out, "        <type>typedef unsigned char <name>GLboolean</name>;</type>\n");
+	fprintf(out, "        <type>typedef unsigned int <name>GLbitfield</name>;</type>\n");
+	fprintf(out, "        <type>typedef int <name>GLint</name>;</type>\n");
+	fprintf(out, "        <type>typedef unsigned int <name>GLuint</name>;</type>\n");
+	fprintf(out, "        <type>typedef int <name>GLsizei</name>;</type>\n");
+	fprintf(out, "        <type>typedef float <name>GLfloat</name>;</type>\n");
+	fprintf(out, "        <type>typedef double <name>GLdouble</name>;</type>\n");
+	fprintf(out, "        <type>typedef unsigned char <name>GLubyte</name>;</type>\n");
+	fprintf(out, "        <type>typedef struct __GLsync *<name>GLsync</name>;</type>\n");
+	fprintf(out, "    </types>\n\n");
+}
+
+static void print_enums(FILE *out, const synth_params &p)
+{
+	const int block_size = 16;
+	int i;
+
+	fprintf(out, "    <enums namespace=\"GL\" group=\"SynthRequired\">\n");
+	fprintf(out, "        <enum value=\"0x821D\" name=\"GL_NUM_EXTENSIONS\"/>\n");
+	fprintf(out, "        <enum value=\"0x821B\" name=\"GL_MAJOR_VERSION\"/>\n");
+	fprintf(out, "        <enum value=\"0x821C\" name=\"GL_MINOR_VERSION\"/>\n");
+	fprintf(out, "        <enum value=\"0x1F03\" name=\"GL_EXTENSIONS\"/>\n");
+	fprintf(out, "        <enum value=\"0xFFFFFFFFFFFFFFFF\" name=\"GL_SYNTH_TIMEOUT_IGNORED\" type=\"ull\"/>\n");
+	fprintf(out, "    </enums>\n\n");
+
+	for (i = 0; i < p.enums; i++) {
+		if ((i % block_size) == 0)
+			fprintf(out, "    <enums namespace=\"GL\" group=\"SynthGroup%d\" vendor=\"ARB\">\n", i / block_size);
+		fprintf(out, "        <enum value=\"0x%X\" name=\"GL_SYNTH_ENUM_%d\"/>\n", 0x10000 + i, i);
+		if ((i % block_size) == block_size - 1 || i == p.enums - 1)
+			fprintf(out, "    </enums>\n\n");
+	}
+}
+
+static void print_command(FILE *out, const char *name, const char *ret_type, int num_params, int seed)
+{
+	int i;
+	fprintf(out, "        <command>\n");
+	if (ret_type)
+		fprintf(out, "            <proto><ptype>%s</ptype> <name>%s</name></proto>\n", ret_type, name);
+	else
+		fprintf(out, "            <proto>void <name>%s</name></proto>\n", name);
+	for (i = 0; i < num_params; i++) {
+		const char *type = g_param_types[(seed + i) % NUM_PARAM_TYPES];
+		if (((seed + i) % 5) == 4)
+			fprintf(out, "            <param len=\"count\">const <ptype>%s</ptype> *<name>values%d</name></param>\n", type, i);
+		else
+			fprintf(out, "            <param><ptype>%s</ptype> <name>arg%d</name></param>\n", type, i);
+	}
+	fprintf(out, "        </command>\n");
+}
+
+static void print_commands(FILE *out, const synth_params &p)
+{
+	int i;
+	char name[64];
+
+	fprintf(out, "    <commands namespace=\"GL\">\n");
+	fprintf(out, "        <command>\n");
+	fprintf(out, "            <proto>void <name>glGetIntegerv</name></proto>\n");
+	fprintf(out, "            <param><ptype>GLenum</ptype> <name>pname</name></param>\n");
+	fprintf(out, "            <param><ptype>GLint</ptype> *<name>data</name></param>\n");
+	fprintf(out, "        </command>\n");
+	fprintf(out, "        <command>\n");
+	fprintf(out, "            <proto>const <ptype>GLubyte</ptype> *<name>glGetStringi</name></proto>\n");
+	fprintf(out, "            <param><ptype>GLenum</ptype> <name>name</name></param>\n");
+	fprintf(out, "            <param><ptype>GLuint</ptype> <name>index</name></param>\n");
+	fprintf(out, "        </command>\n");
+	for (i = 0; i < p.commands; i++) {
+		snprintf(name, sizeof(name), "glSynthCommand%d", i);
+		print_command(out, name, (i % 7) == 3 ? g_param_types[i % NUM_PARAM_TYPES] : NULL, p.params, i);
+	}
+	fprintf(out, "    </commands>\n\n");
+}
+
+//
+//The first half of the commands and enums is dealt out round robin over the
+//features and the second half over the extensions. With no extensions
+//everything goes to the features.
+//
+static void print_require_range(FILE *out, const char *format, int count, int slots, int extensions, bool feature, int index)
+{
+	int half = extensions ? count / 2 : count;
+	int first = feature ? index : half + index;
+	int end = feature ? half : count;
+	int i;
+	for (i = first; i < end; i += slots)
+		fprintf(out, format, i);
+}
+
+static void print_requires(FILE *out, const synth_params &p, bool feature, int index)
+{
+	int slots = feature ? p.features : p.extensions;
+	fprintf(out, "        <require>\n");
+	print_require_range(out, "            <enum name=\"GL_SYNTH_ENUM_%d\"/>\n", p.enums, slots, p.extensions, feature, index);
+	print_require_range(out, "            <command name=\"glSynthCommand%d\"/>\n", p.commands, slots, p.extensions, feature, index);
+	fprintf(out, "        </require>\n");
+}
+
+static void print_features(FILE *out, const synth_params &p)
+{
+	int i;
+	unsigned int j;
+	for (i = 0; i < p.features; i++) {
+		int major = 1 + i / 10;
+		int minor = i % 10;
+		fprintf(out, "    <feature api=\"gl\" name=\"GL_VERSION_%d_%d\" number=\"%d.%d\">\n", major, minor, major, minor);
+		if (i == 0) {
+			fprintf(out, "        <require>\n");
+			for (j = 0; j < sizeof(g_required_enums) / sizeof(g_required_enums[0]); j++)
+				fprintf(out, "            <enum name=\"%s\"/>\n", g_required_enums[j]);
+			fprintf(out, "            <enum name=\"GL_SYNTH_TIMEOUT_IGNORED\"/>\n");
+			for (j = 0; j < sizeof(g_required_commands) / sizeof(g_required_commands[0]); j++)
+				fprintf(out, "            <command name=\"%s\"/>\n", g_required_commands[j]);
+			fprintf(out, "        </require>\n");
+		}
+		print_requires(out, p, true, i);
+		fprintf(out, "    </feature>\n");
+	}
+	fprintf(out, "\n");
+}
+
+static void print_extensions(FILE *out, const synth_params &p)
+{
+	int i;
+	fprintf(out, "    <extensions>\n");
+	for (i = 0; i < p.extensions; i++) {
+		fprintf(out, "        <extension name=\"GL_SYNTH_extension_%d\" supported=\"gl|glcore\">\n", i);
+		print_requires(out, p, false, i);
+		fprintf(out, "        </extension>\n");
+	}
+	fprintf(out, "    </extensions>\n");
+}
+
+static void print_help(const char *program_name)
+{
+	printf("Usage: %s [OPTION]...\n", program_name);
+	printf("\n"
+	       "Writes a synthetic OpenGL registry that glbindify can read as gl.xml\n"
+	       "\n"
+	       "Options:\n"
+	       "  -x,--scale <factor>           Size relative to gl.xml. Sets all counts below\n"
+	       "                                that are not given explicitly. Default is 1\n"
+	       "  -c,--commands <count>         Number of commands\n"
+	       "  -p,--params <count>           Number of parameters per command\n"
+	       "  -e,--enums <count>            Number of enums\n"
+	       "  -f,--features <count>         Number of feature levels\n"
+	       "  -E,--extensions <count>       Number of extensions\n"
+	       "  -o,--output <file>            Output file. Default is stdout\n"
+	       "  -h,--help                     Display this page\n");
+}
+
+int main(int argc, char **argv)
+{
+	static struct option options [] = {
+		{"scale"      , 1, 0, 'x' },
+		{"commands"   , 1, 0, 'c' },
+		{"params"     , 1, 0, 'p' },
+		{"enums"      , 1, 0, 'e' },
+		{"features"   , 1, 0, 'f' },
+		{"extensions" , 1, 0, 'E' },
+		{"output"     , 1, 0, 'o' },
+		{"help"       , 0, 0, 'h' },
+		{0            , 0, 0,  0  }
+	};
+
+	double scale = 1.0;
+	synth_params p = { -1, -1, -1, -1, -1 };
+	const char *output = NULL;
+
+	while (1) {
+		int option_index;
+		int c = getopt_long(argc, argv, "x:c:p:e:f:E:o:h", options, &option_index);
+		if (c == -1) {
+			break;
+		}
+		switch (c) {
+		case '?':
+		case ':':
+			print_help(argv[0]);
+			exit(-1);
+			break;
+		case 'x':
+			scale = atof(optarg);
+			break;
+		case 'c':
+			p.commands = atoi(optarg);
+			break;
+		case 'p':
+			p.params = atoi(optarg);
+			break;
+		case 'e':
+			p.enums = atoi(optarg);
+			break;
+		case 'f':
+			p.features = atoi(optarg);
+			break;
+		case 'E':
+			p.extensions = atoi(optarg);
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'h':
+			print_help(argv[0]);
+			exit(0);
+			break;
+		}
+	}
+
+	if (scale <= 0) {
+		fprintf(stderr, "Scale must be positive\n");
+		exit(-1);
+	}
+
+	if (p.commands < 0)
+		p.commands = (int)(g_gl_xml_size.commands * scale);
+	if (p.params < 0)
+		p.params = g_gl_xml_size.params;
+	if (p.enums < 0)
+		p.enums = (int)(g_gl_xml_size.enums * scale);
+	if (p.features < 0)
+		p.features = (int)(g_gl_xml_size.features * scale);
+	if (p.extensions < 0)
+		p.extensions = (int)(g_gl_xml_size.extensions * scale);
+	if (p.features < 1)
+		p.features = 1;
+
+	FILE *out = stdout;
+	if (output) {
+		out = fopen(output, "w");
+		if (!out) {
+			fprintf(stderr, "Error creating '%s'\n", output);
+			exit(-1);
+		}
+	}
+
+	fprintf(out, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	fprintf(out, "<registry>\n");
+	fprintf(out, "    <comment>Synthetic registry: %d commands, %d params per command, %d enums, %d features, %d extensions</comment>\n\n",
+			p.commands, p.params, p.enums, p.features, p.extensions);
+	print_types(out);
+	print_enums(out, p);
+	print_commands(out, p);
+	print_features(out, p);
+	print_extensions(out, p);
+	fprintf(out, "</registry>\n");
+
+	if (out != stdout)
+		fclose(out);
+	return 0;
+}
@@ -0,0 +1,61 @@
+#!/bin/sh
+#
+# Runs glbindify over synthetic registries of increasing size and records
+# the time and memory it needs. Sizes are multiples of gl.xml.
+#
+# Usage: scaling.sh [glbindify] [regsynth] [scale]...
+#
+# Writes scaling.dat to the current directory and, if gnuplot is available,
+# scaling.png with time and peak RSS plotted against registry size.
+#
+
+GLBINDIFY=${1:-./glbindify}
+REGSYNTH=${2:-./regsynth}
+[ $# -ge 2 ] && shift 2 || shift $#
+SCALES=${*:-"0.5 1 2 5 10 20"}
+
+case $GLBINDIFY in /*) ;; *) GLBINDIFY=$(pwd)/$GLBINDIFY ;; esac
+case $REGSYNTH in /*) ;; *) REGSYNTH=$(pwd)/$REGSYNTH ;; esac
+
+WORKDIR=${TMPDIR:-/tmp}/glbindify-scaling.$$
+mkdir -p "$WORKDIR/out" || exit 1
+trap 'rm -rf "$WORKDIR"' EXIT
+
+echo "# scale xml_bytes load_ms visit_ms emit_ms total_ms peak_rss_kib" > scaling.dat
+for scale in $SCALES; do
+	"$REGSYNTH" --scale "$scale" --output "$WORKDIR/gl.xml" || exit 1
+	bytes=$(wc -c < "$WORKDIR/gl.xml")
+	(cd "$WORKDIR/out" && "$GLBINDIFY" -a gl -s "$WORKDIR" --stats > /dev/null 2> "$WORKDIR/stats") || {
+		cat "$WORKDIR/stats"
+		exit 1
+	}
+	awk -v scale="$scale" -v bytes="$bytes" '
+		/^load:/ { load = $2 }
+		/^visit:/ { visit = $2 }
+		/^emit:/ { emit = $2 }
+		/^total:/ { total = $2 }
+		/^peak_rss:/ { rss = $2 }
+		END { print scale, bytes, load, visit, emit, total, rss }' "$WORKDIR/stats" >> scaling.dat
+	tail -n 1 scaling.dat
+done
+
+if command -v gnuplot > /dev/null 2>&1; then
+	gnuplot <<EOF
+set terminal png size 1000,450
+set output "scaling.png"
+set multiplot layout 1,2
+set xlabel "registry size (MiB)"
+set key left top
+set ylabel "time (ms)"
+plot "scaling.dat" using (\$2/1048576):3 with linespoints title "load", \
+     "scaling.dat" using (\$2/1048576):4 with linespoints title "visit", \
+     "scaling.dat" using (\$2/1048576):5 with linespoints title "emit", \
+     "scaling.dat" using (\$2/1048576):6 with linespoints title "total"
+set ylabel "peak RSS (MiB)"
+plot "scaling.dat" using (\$2/1048576):(\$7/1024) with linespoints title "peak RSS"
+unset multiplot
+EOF
+	echo "Wrote scaling.dat and scaling.png"
+else
+	echo "Wrote scaling.dat (install gnuplot to get scaling.png)"
+fi
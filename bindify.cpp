@@ -0,0 +1,1015 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+
+#include <vector>
+
+#include "registry.h"
+#include "thread.h"
+#include "writer.h"
+
+#define USE_GPERF HAVE_GPERF && !defined(_WIN32)
+
+#if USE_GPERF
+#include <sys/wait.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+namespace glbindify {
+
+//Indexed by enum_suffix
+static const char *const enum_suffixes[] = { "", "u", "ull" };
+
+void command::print_declare(writer &out, const char *command_prefix) const
+{
+	out.indent().write("extern ").write(type_decl).write(" (*").write(command_prefix).write(name).write(")(");
+	out.write(signature, signature_length).write(");\n");
+}
+
+void command::print_initialize(writer &out, const char *command_prefix) const
+{
+	out.indent().write(type_decl).write(" (*").write(command_prefix).write(name).write(")(");
+	out.write(signature, signature_length).write(") = NULL;\n");
+}
+
+void command::print_load(writer &out, const char *command_prefix) const
+{
+	out.indent().write(command_prefix).write(name).write(" = (").write(type_decl).write(" (*)(");
+	out.write(signature, signature_length).write(") ) LoadProcAddress(\"").write(command_prefix).write(name).write("\");\n");
+}
+
+//
+//State for writing the bindings of one registry
+//
+struct emitter {
+	const registry::model &m;
+	const char *prefix;
+	std::string macro_prefix;
+	const char *command_prefix;
+	const char *enumeration_prefix;
+	enum_style enums;
+
+	//Starts of the lines repeated for every enum and command
+	std::string undef_enum;
+	std::string define_enum;
+	std::string undef_command;
+	std::string define_command;
+	std::string command_alias;
+
+	emitter(const registry::model &model, const char *prefix, enum_style enums = ENUM_STYLE_MACRO) :
+		m(model),
+		prefix(prefix),
+		macro_prefix(prefix),
+		command_prefix(model.command_prefix),
+		enumeration_prefix(model.enumeration_prefix),
+		enums(enums)
+	{
+		for (size_t i = 0; i < macro_prefix.size(); i++)
+			macro_prefix[i] = toupper(macro_prefix[i]);
+		undef_enum = std::string("#undef ") + enumeration_prefix;
+		define_enum = std::string("#define ") + enumeration_prefix;
+		undef_command = std::string("#undef ") + command_prefix;
+		define_command = std::string("#define ") + command_prefix;
+		command_alias = std::string(" _") + prefix + "_" + command_prefix;
+	}
+
+	void print_enum_macro(const char *name, writer &header) const;
+	void print_enum_declarations(const interface &base, writer &header) const;
+	void print_interface_declaration(const interface *iface, writer &header) const;
+	void print_interface_load_check(const interface *iface, writer &source) const;
+#if USE_GPERF
+	void print_extension_hash(writer &source) const;
+#endif
+};
+
+void emitter::print_enum_macro(const char *name, writer &header) const
+{
+	enum_map_type::const_iterator iter = m.enum_map.find(name);
+	header.write(undef_enum).write(name).write('\n');
+	header.write(define_enum).write(name);
+	if (iter != m.enum_map.end()) {
+		header.write(" 0x").write_hex(iter->second.value).write(enum_suffixes[iter->second.suffix]);
+	} else {
+		enum_str_map_type::const_iterator str = m.enum_str_map.find(name);
+		header.write(' ').write(str != m.enum_str_map.end() ? str->second : "(null)");
+	}
+	header.write('\n');
+}
+
+//
+//An enum declared by print_enum_declarations(), with the index of the
+//enumeration (registry group) it is in or NO_GROUP if it is not a number
+//
+struct enum_declaration {
+	const char *name;
+	unsigned int group;
+	enum_value value;
+};
+
+#define NO_GROUP 0xffffffff
+
+struct enum_blocks {
+	//Indices of the blocks that have the enum, 0 for the base interface
+	std::vector<unsigned int> blocks;
+	bool declared;
+	enum_blocks() : declared(false) {}
+};
+
+typedef std::map<const char *, enum_blocks, cstring_compare> enum_blocks_type;
+typedef std::map<std::vector<unsigned int>, std::vector<enum_declaration> > enum_sections_type;
+
+//
+//C type of a hexadecimal literal with this value
+//
+static const char *enum_const_type(const enum_value &value)
+{
+	if (value.suffix == ENUM_SUFFIX_ULL || value.value > 0xffffffffu)
+		return "unsigned long long";
+	if (value.suffix == ENUM_SUFFIX_U || value.value > 0x7fffffff)
+		return "unsigned int";
+	return "int";
+}
+
+//
+//Declare every enum of the bindings once, for the styles other than macros.
+//An enum that is in the base interface is declared unconditionally. Others
+//are declared if any feature or extension that has them is enabled, which
+//for features is the first one. Enums with the same blocks are declared
+//together, grouped as in the registry.
+//
+//Enums removed by features after the base interface stay declared.
+//
+void emitter::print_enum_declarations(const interface &base, writer &header) const
+{
+	std::vector<std::string> conditions(1);
+	enum_blocks_type enum_blocks;
+	FOREACH_CONST (val, base.enums, enums_type)
+		enum_blocks[*val].blocks.push_back(0);
+	FOREACH_CONST (iter, m.feature_interfaces, feature_interfaces_type) {
+		if (iter->first <= m.min_version)
+			continue;
+		unsigned int block = conditions.size();
+		char version[16];
+		snprintf(version, sizeof(version), "%d", iter->first);
+		conditions.push_back(std::string("(defined(") + macro_prefix + "_" + enumeration_prefix + "VERSION) && " +
+				macro_prefix + "_" + enumeration_prefix + "VERSION >= " + version + ")");
+		FOREACH_CONST (val, iter->second->enums, enums_type) {
+			std::vector<unsigned int> &blocks = enum_blocks[*val].blocks;
+			if (blocks.empty())
+				blocks.push_back(block);
+		}
+	}
+	FOREACH_CONST (iter, m.extension_interfaces, extension_interfaces_type) {
+		unsigned int block = conditions.size();
+		conditions.push_back(std::string("defined(") + macro_prefix + "_ENABLE_" + enumeration_prefix + iter->first + ")");
+		FOREACH_CONST (val, iter->second->enums, enums_type) {
+			std::vector<unsigned int> &blocks = enum_blocks[*val].blocks;
+			if (blocks.empty() || blocks[0])
+				blocks.push_back(block);
+		}
+	}
+
+	enum_sections_type sections;
+	for (unsigned int i = 0; i < m.enumerations.size(); i++) {
+		FOREACH_CONST (val, m.enumerations[i]->enum_map, enum_map_type) {
+			enum_blocks_type::iterator iter = enum_blocks.find(val->first);
+			if (iter == enum_blocks.end() || iter->second.declared)
+				continue;
+			iter->second.declared = true;
+			enum_declaration decl = { iter->first, i, val->second };
+			sections[iter->second.blocks].push_back(decl);
+		}
+	}
+	FOREACH (iter, enum_blocks, enum_blocks_type) {
+		if (!iter->second.declared) {
+			enum_declaration decl = { iter->first, NO_GROUP, { 0, ENUM_SUFFIX_NONE } };
+			sections[iter->second.blocks].push_back(decl);
+		}
+	}
+
+	FOREACH_CONST (iter, sections, enum_sections_type) {
+		const std::vector<unsigned int> &blocks = iter->first;
+		const std::vector<enum_declaration> &decls = iter->second;
+		header.write('\n');
+		if (blocks[0]) {
+			header.write("#if ").write(conditions[blocks[0]]);
+			for (unsigned int i = 1; i < blocks.size(); i++)
+				header.write(" || \\\n\t").write(conditions[blocks[i]]);
+			header.write('\n');
+		}
+		size_t group_begin = 0;
+		while (group_begin < decls.size()) {
+			unsigned int group = decls[group_begin].group;
+			size_t group_end = group_begin;
+			while (group_end < decls.size() && decls[group_end].group == group)
+				group_end++;
+			if (group != NO_GROUP && m.enumerations[group]->name)
+				header.write("/* ").write(m.enumerations[group]->name).write(" */\n");
+
+			bool in_enum = false;
+			for (size_t i = group_begin; i < group_end; i++) {
+				const enum_declaration &decl = decls[i];
+				if (group == NO_GROUP)
+					continue;
+				if (enums == ENUM_STYLE_CONST) {
+					header.write("static const ").write(enum_const_type(decl.value)).write(' ');
+					header.write(enumeration_prefix).write(decl.name);
+					header.write(" = 0x").write_hex(decl.value.value).write(enum_suffixes[decl.value.suffix]).write(";\n");
+				} else if (decl.value.suffix == ENUM_SUFFIX_NONE && decl.value.value <= 0x7fffffff) {
+					header.write(in_enum ? ",\n\t" : "enum {\n\t");
+					header.write(enumeration_prefix).write(decl.name);
+					header.write(" = 0x").write_hex(decl.value.value);
+					in_enum = true;
+				}
+			}
+			if (in_enum)
+				header.write("\n};\n");
+
+			//What the style can't declare
+			for (size_t i = group_begin; i < group_end; i++) {
+				const enum_declaration &decl = decls[i];
+				if (group == NO_GROUP || (enums == ENUM_STYLE_ENUM &&
+						(decl.value.suffix != ENUM_SUFFIX_NONE || decl.value.value > 0x7fffffff)))
+					print_enum_macro(decl.name, header);
+			}
+			group_begin = group_end;
+		}
+		if (blocks[0])
+			header.write("#endif\n");
+	}
+}
+
+void emitter::print_interface_declaration(const interface *iface, writer &header) const
+{
+	if (enums == ENUM_STYLE_MACRO) {
+		FOREACH_CONST (val, iface->removed_enums, enums_type)
+			header.write(undef_enum).write(*val).write('\n');
+
+		FOREACH_CONST (val, iface->enums, enums_type)
+			print_enum_macro(*val, header);
+
+		if (iface->enums.size())
+			header.indent().write('\n');
+	}
+	FOREACH_CONST (iter, iface->removed_commands, commands_type)
+		header.write(undef_command).write(iter->second->name).write('\n');
+	FOREACH_CONST (iter, iface->commands, commands_type) {
+		const command *command = iter->second;
+		header.write(undef_command).write(command->name).write('\n');
+		header.write(define_command).write(command->name).write(command_alias).write(command->name).write('\n');
+		command->print_declare(header, command_prefix);
+	}
+}
+
+static void interface_append(struct interface *iface, const interface &other)
+{
+	iface->enums.insert(other.enums.begin(), other.enums.end());
+	FOREACH_CONST (e, other.removed_enums, enums_type)
+		iface->enums.erase(*e);
+	iface->commands.insert(other.commands.begin(), other.commands.end());
+	FOREACH_CONST (iter, other.removed_commands, commands_type)
+		iface->commands.erase(iter->first);
+}
+
+void emitter::print_interface_load_check(const interface *iface, writer &source) const
+{
+	if (!iface->commands.size()) {
+		source.write("true");
+	} else {
+		int i = 0;
+		FOREACH_CONST (iter,  iface->commands, commands_type) {
+			if ((i % 3) == 2)
+				source.write('\n').indent();
+			if (i)
+				source.write(" && ");
+			source.write(command_prefix).write(iter->first);
+			i++;
+		}
+	}
+}
+
+#if USE_GPERF
+//
+//Have gperf make a hash table for extension names. Its input is staged in a
+//temporary file and its output is read back through a pipe into the source.
+//
+void emitter::print_extension_hash(writer &source) const
+{
+	FILE *gperf_in = tmpfile();
+	if (!gperf_in) {
+		fprintf(stderr, "tmpfile() failed: %s. Aborting...\n", strerror(errno));
+		exit(-1);
+	}
+	fprintf(gperf_in, "%%struct-type\n");
+	fprintf(gperf_in, "%%define lookup-function-name %s_find_extension\n", prefix);
+	fprintf(gperf_in, "%%define initializer-suffix ,NULL\n");
+	fprintf(gperf_in, "struct extension_match { const char *name; bool *support_flag; };\n");
+	fprintf(gperf_in, "%%%%\n");
+	FOREACH_CONST (iter, m.extension_interfaces, extension_interfaces_type) {
+		fprintf(gperf_in, "%s%s, &%s_%s%s\n", enumeration_prefix, iter->first,
+			macro_prefix.c_str(), enumeration_prefix, iter->first);
+	}
+	fflush(gperf_in);
+	rewind(gperf_in);
+
+	int fdpair[2];
+	if (pipe(fdpair)) {
+		fprintf(stderr, "pipe() failed: %s. Aborting...\n", strerror(errno));
+		exit(-1);
+	}
+	pid_t child_pid = fork();
+	if (child_pid) {
+		int status;
+		pid_t pid;
+		char buf[4096];
+		ssize_t count;
+		close(fdpair[1]);
+		while ((count = read(fdpair[0], buf, sizeof(buf))) > 0 || (count < 0 && errno == EINTR)) {
+			if (count > 0)
+				source.write(buf, count);
+		}
+		close(fdpair[0]);
+		fclose(gperf_in);
+		pid = waitpid(child_pid, &status, 0);
+		if (pid != child_pid || WEXITSTATUS(status)) {
+			fprintf(stderr, "Error encountered while running gperf\n");
+			exit(-1);
+		}
+	} else {
+		close(fdpair[0]);
+		dup2(fileno(gperf_in), STDIN_FILENO);
+		dup2(fdpair[1], STDOUT_FILENO);
+		execlp("gperf", "gperf", (char *)0);
+		_exit(-1);
+	}
+}
+#endif
+
+void format_feature_declaration(const registry::model &m, const char *prefix, enum_style enums,
+		int version, const interface &iface, std::string *out)
+{
+	emitter e(m, prefix, enums);
+	string_sink sink;
+	writer header_file(sink);
+	header_file.indent_print("\n");
+	header_file.indent_print("#if defined(%s_%sVERSION) && %s_%sVERSION >= %d\n",
+			e.macro_prefix.c_str(),
+			e.enumeration_prefix,
+			e.macro_prefix.c_str(),
+			e.enumeration_prefix,
+			version);
+	e.print_interface_declaration(&iface, header_file);
+	header_file.indent_print("#endif\n");
+	header_file.flush();
+	out->swap(sink.str);
+}
+
+void format_extension_declaration(const registry::model &m, const char *prefix, enum_style enums,
+		const char *name, const interface &iface, std::string *out)
+{
+	emitter e(m, prefix, enums);
+	string_sink sink;
+	writer header_file(sink);
+	const char *macro_prefix = e.macro_prefix.c_str();
+	header_file.indent_print("\n");
+	header_file.indent_print("#if defined(%s_ENABLE_%s%s)\n", macro_prefix, e.enumeration_prefix, name);
+	header_file.indent_print("extern bool %s_%s%s;\n", macro_prefix, e.enumeration_prefix, name);
+	e.print_interface_declaration(&iface, header_file);
+	header_file.indent_print("#endif\n");
+	header_file.flush();
+	out->swap(sink.str);
+}
+
+//
+//Written inside init() where the indentation is one level deep
+//
+void format_extension_check(const registry::model &m, const char *prefix, const char *name,
+		const interface &iface, std::string *out)
+{
+	emitter e(m, prefix);
+	string_sink sink;
+	writer source_file(sink);
+	const char *macro_prefix = e.macro_prefix.c_str();
+	source_file.increase_indent();
+	source_file.indent_print("\n");
+	source_file.indent_print("%s_%s%s = %s_%s%s && ",
+			macro_prefix, e.enumeration_prefix, name,
+			macro_prefix, e.enumeration_prefix, name);
+	source_file.increase_indent();
+	e.print_interface_load_check(&iface, source_file);
+	source_file.decrease_indent();
+	source_file.print(";\n");
+	source_file.flush();
+	out->swap(sink.str);
+}
+
+//
+//A header of split bindings declaring one feature or extension. It only
+//includes 'dependency', which declares everything it builds on.
+//
+static void format_split_header(const emitter &e, const std::string &file_name, const std::string &dependency,
+		const char *extension, const interface &iface, std::string *out)
+{
+	string_sink sink;
+	writer header_file(sink);
+	std::string guard = std::string("GL_BINDIFY_") + e.m.api_name + "_" + file_name.substr(0, file_name.size() - 2) + "_H";
+	header_file.print("#ifndef %s\n", guard.c_str());
+	header_file.print("#define %s\n", guard.c_str());
+	header_file.print("#include \"%s\"\n", dependency.c_str());
+	header_file.print("#ifdef __cplusplus\n");
+	header_file.print("extern \"C\" {\n");
+	header_file.print("#endif\n");
+	if (extension)
+		header_file.indent_print("extern bool %s_%s%s;\n", e.macro_prefix.c_str(), e.enumeration_prefix, extension);
+	e.print_interface_declaration(&iface, header_file);
+	header_file.print("#ifdef __cplusplus\n");
+	header_file.print("}\n"); //extern "C" {
+	header_file.print("#endif\n");
+	header_file.print("#endif\n");
+	header_file.flush();
+	out->swap(sink.str);
+}
+
+static std::string feature_header_name(const registry::model &m, int version)
+{
+	char name[64];
+	snprintf(name, sizeof(name), "%sVERSION_%d_%d.h", m.enumeration_prefix, version / 10, version % 10);
+	return name;
+}
+
+static std::string extension_header_name(const registry::model &m, const char *extension)
+{
+	return std::string(m.enumeration_prefix) + extension + ".h";
+}
+
+static const std::string *find_prepared(const extension_text_type &texts, const char *name)
+{
+	extension_text_type::const_iterator iter = texts.find(name);
+	return iter != texts.end() ? &iter->second : NULL;
+}
+
+//
+//Commands are defined and loaded in runs of this many per chunk
+//
+#define COMMANDS_PER_CHUNK 128
+
+//
+//A piece of the output that does not depend on the text around it. Chunks
+//are formatted in any order, possibly concurrently, and written in order.
+//
+struct chunk {
+	enum chunk_kind {
+		FEATURE_DECLARATION,
+		EXTENSION_DECLARATION,
+		COMMAND_DEFINITIONS,
+		COMMAND_LOADS,
+		EXTENSION_CHECK,
+		FEATURE_CHECK
+	} kind;
+	int version;
+	const char *name;
+	const interface *iface;
+	commands_type::const_iterator first;
+	commands_type::const_iterator last;
+
+	//Text formatted while the registry was loaded, if any
+	const std::string *prepared;
+	std::string text;
+
+	//With split headers, declarations are formatted as the header
+	//'split_name' that includes 'split_dependency'
+	std::string split_name;
+	std::string split_dependency;
+};
+
+static void format_chunk(const emitter &e, chunk &c)
+{
+	if (c.prepared)
+		return;
+	string_sink sink;
+	writer out(sink);
+	switch (c.kind) {
+	case chunk::FEATURE_DECLARATION:
+		if (c.split_name.size())
+			format_split_header(e, c.split_name, c.split_dependency, NULL, *c.iface, &c.text);
+		else
+			format_feature_declaration(e.m, e.prefix, e.enums, c.version, *c.iface, &c.text);
+		return;
+	case chunk::EXTENSION_DECLARATION:
+		if (c.split_name.size())
+			format_split_header(e, c.split_name, c.split_dependency, c.name, *c.iface, &c.text);
+		else
+			format_extension_declaration(e.m, e.prefix, e.enums, c.name, *c.iface, &c.text);
+		return;
+	case chunk::EXTENSION_CHECK:
+		format_extension_check(e.m, e.prefix, c.name, *c.iface, &c.text);
+		return;
+	case chunk::COMMAND_DEFINITIONS:
+		for (commands_type::const_iterator iter = c.first; iter != c.last; iter++)
+			iter->second->print_initialize(out, e.command_prefix);
+		break;
+	case chunk::COMMAND_LOADS:
+		//Inside init()
+		out.increase_indent();
+		for (commands_type::const_iterator iter = c.first; iter != c.last; iter++)
+			iter->second->print_load(out, e.command_prefix);
+		break;
+	case chunk::FEATURE_CHECK:
+		//Continues the return statement of init()
+		out.increase_indent();
+		out.print("\n");
+		out.indent_print(" && ((req_version < %d) ||\n", c.version);
+		out.increase_indent();
+		out.indent_print("(");
+		e.print_interface_load_check(c.iface, out);
+		out.print("))");
+		break;
+	}
+	out.flush();
+	c.text.swap(sink.str);
+}
+
+class chunk_formatter : public thread {
+	const emitter &m_emitter;
+	std::vector<chunk> &m_chunks;
+	size_t m_first;
+	size_t m_stride;
+
+	void run()
+	{
+		for (size_t i = m_first; i < m_chunks.size(); i += m_stride)
+			format_chunk(m_emitter, m_chunks[i]);
+	}
+public:
+	chunk_formatter(const emitter &e, std::vector<chunk> &chunks, size_t first, size_t stride) :
+		m_emitter(e), m_chunks(chunks), m_first(first), m_stride(stride)
+	{
+	}
+};
+
+//
+//Format every chunk using up to 'threads' threads, each taking every
+//'threads'th chunk. The calling thread takes the first share.
+//
+static void format_chunks(const emitter &e, std::vector<chunk> &chunks, unsigned int threads)
+{
+	if (!threads)
+		threads = processor_count();
+	if (threads > chunks.size())
+		threads = chunks.size();
+	if (threads < 1 || !thread::supported())
+		threads = 1;
+
+	std::vector<chunk_formatter *> formatters;
+	for (unsigned int i = 1; i < threads; i++) {
+		formatters.push_back(new chunk_formatter(e, chunks, i, threads));
+		formatters.back()->start();
+	}
+	for (size_t i = 0; i < chunks.size(); i += threads)
+		format_chunk(e, chunks[i]);
+	for (size_t i = 0; i < formatters.size(); i++) {
+		formatters[i]->join();
+		delete formatters[i];
+	}
+}
+
+static chunk &add_chunk(std::vector<chunk> &chunks, chunk::chunk_kind kind, const interface *iface)
+{
+	chunk c;
+	c.kind = kind;
+	c.version = 0;
+	c.name = NULL;
+	c.iface = iface;
+	c.prepared = NULL;
+	chunks.push_back(c);
+	return chunks.back();
+}
+
+static void add_command_chunks(std::vector<chunk> &chunks, chunk::chunk_kind kind, const commands_type &commands)
+{
+	commands_type::const_iterator iter = commands.begin();
+	while (iter != commands.end()) {
+		chunk &c = add_chunk(chunks, kind, NULL);
+		c.first = iter;
+		for (int i = 0; i < COMMANDS_PER_CHUNK && iter != commands.end(); i++)
+			iter++;
+		c.last = iter;
+	}
+}
+
+//
+//Write the run of chunks of one kind starting at 'next' and return the
+//index after it
+//
+static size_t write_chunks(writer &out, const std::vector<chunk> &chunks, size_t next, chunk::chunk_kind kind)
+{
+	for (; next < chunks.size() && chunks[next].kind == kind; next++)
+		out.write(chunks[next].prepared ? *chunks[next].prepared : chunks[next].text);
+	return next;
+}
+
+//
+//Hand the split headers formatted by the run of chunks of one kind starting
+//at 'next' to 'headers', and include each in 'out' under the condition that
+//would otherwise enable its declarations. Returns the index after the run.
+//
+static size_t write_split_chunks(const emitter &e, writer &out, const std::vector<chunk> &chunks, size_t next,
+		chunk::chunk_kind kind, const std::string &directory, header_set &headers)
+{
+	const char *macro_prefix = e.macro_prefix.c_str();
+	for (; next < chunks.size() && chunks[next].kind == kind; next++) {
+		const chunk &c = chunks[next];
+		std::string name = directory + "/" + c.split_name;
+		if (kind == chunk::FEATURE_DECLARATION)
+			out.indent_print("#if defined(%s_%sVERSION) && %s_%sVERSION >= %d\n",
+					macro_prefix, e.enumeration_prefix, macro_prefix, e.enumeration_prefix, c.version);
+		else
+			out.indent_print("#if defined(%s_ENABLE_%s%s)\n", macro_prefix, e.enumeration_prefix, c.name);
+		out.indent_print("#include \"%s\"\n", name.c_str());
+		out.indent_print("#endif\n");
+		headers.add(name, c.text);
+	}
+	return next;
+}
+
+//
+//Finds the types the bindings need: those the <ptype>s of the emitted
+//commands name, those cast to by emitted enums and, in turn, those these
+//depend on through 'requires' or by naming them in their declaration. The
+//registry does not mark types named inside type declarations or enum values,
+//so every identifier in them is looked up.
+//
+class type_marker {
+	const types_type &m_types;
+	std::map<const char *, unsigned int, cstring_compare> m_index;
+	std::vector<unsigned int> m_queue;
+	std::string m_identifier;
+public:
+	std::vector<bool> used;
+
+	type_marker(const types_type &types) : m_types(types), used(types.size(), false)
+	{
+		for (unsigned int i = 0; i < types.size(); i++)
+			m_index[types[i].name] = i;
+	}
+
+	void use(const char *name)
+	{
+		if (!name)
+			return;
+		std::map<const char *, unsigned int, cstring_compare>::const_iterator iter = m_index.find(name);
+		if (iter != m_index.end() && !used[iter->second]) {
+			used[iter->second] = true;
+			m_queue.push_back(iter->second);
+		}
+	}
+
+	void use_identifiers(const char *text, size_t length)
+	{
+		const char *end = text + length;
+		const char *p = text;
+		while (p < end) {
+			if (isalpha((unsigned char)*p) || *p == '_') {
+				const char *begin = p;
+				while (p < end && (isalnum((unsigned char)*p) || *p == '_'))
+					p++;
+				m_identifier.assign(begin, p - begin);
+				use(m_identifier.c_str());
+			} else {
+				p++;
+			}
+		}
+	}
+
+	void use_command(const command &command)
+	{
+		use(command.type);
+		for (unsigned int i = 0; i < command.params.size(); i++)
+			use(command.params[i].type);
+	}
+
+	//
+	//Mark the dependencies of everything marked so far
+	//
+	void close()
+	{
+		while (m_queue.size()) {
+			const type &type = m_types[m_queue.back()];
+			m_queue.pop_back();
+			use(type.requires);
+			use_identifiers(type.decl.data(), type.decl.size());
+		}
+	}
+};
+
+//
+//With 'split', the features after the lowest version and the extensions are
+//declared in headers of their own, which are handed to it
+//
+static void write_bindings(const registry &reg, const options &opts, output_sink &header_sink, output_sink &source_sink,
+		header_set *split)
+{
+	const registry::model &m = reg.get_model();
+	emitter e(m, opts.prefix, opts.enums);
+	writer header_file(header_sink);
+	writer source_file(source_sink);
+	const char *macro_prefix = e.macro_prefix.c_str();
+	const char *enumeration_prefix = m.enumeration_prefix;
+	const char *prefix = opts.prefix;
+	std::string default_header_name = std::string(m.variant_name) + ".h";
+	const char *header_name = opts.header_name ? opts.header_name : default_header_name.c_str();
+	int min_version = m.min_version;
+	bool use_prepared = !split && m.prepared.valid && m.prepared.prefix == prefix && m.prepared.enums == opts.enums;
+
+	//
+	//Split headers go in a directory named after the main header, next to it
+	//
+	const char *header_base = strrchr(header_name, '/');
+	header_base = header_base ? header_base + 1 : header_name;
+	std::string split_directory(header_base);
+	if (split_directory.size() > 2 && !split_directory.compare(split_directory.size() - 2, 2, ".h"))
+		split_directory.resize(split_directory.size() - 2);
+	std::string split_main = std::string("../") + header_base;
+
+	interface full_interface;
+	interface base_interface;
+	int max_version = min_version;
+
+	bool is_gl_api = m.api == API_GL;
+	FOREACH_CONST (iter, m.feature_interfaces, feature_interfaces_type) {
+		if (iter->first <= min_version)
+			interface_append(&base_interface, *(iter->second));
+		max_version = iter->first > max_version ? iter->first : max_version;
+		interface_append(&full_interface,*(iter->second));
+	}
+	FOREACH_CONST (iter, m.extension_interfaces, extension_interfaces_type) {
+		interface_append(&full_interface, *(iter->second));
+	}
+
+	//
+	//Everything repeated per feature, extension or command is formatted
+	//up front, in the order it is written
+	//
+	std::vector<chunk> chunks;
+	std::string previous_feature = split_main;
+	FOREACH_CONST (iter, m.feature_interfaces, feature_interfaces_type) {
+		if (iter->first > min_version) {
+			chunk &c = add_chunk(chunks, chunk::FEATURE_DECLARATION, iter->second);
+			c.version = iter->first;
+			std::map<int, std::string>::const_iterator text = m.prepared.features.find(iter->first);
+			if (use_prepared && text != m.prepared.features.end())
+				c.prepared = &text->second;
+			if (split) {
+				//Each version builds on the one before it
+				c.split_name = feature_header_name(m, iter->first);
+				c.split_dependency = previous_feature;
+				previous_feature = c.split_name;
+			}
+		}
+	}
+	FOREACH_CONST (iter, m.extension_interfaces, extension_interfaces_type) {
+		chunk &c = add_chunk(chunks, chunk::EXTENSION_DECLARATION, iter->second);
+		c.name = iter->first;
+		c.prepared = use_prepared ? find_prepared(m.prepared.extensions, iter->first) : NULL;
+		if (split) {
+			c.split_name = extension_header_name(m, iter->first);
+			c.split_dependency = split_main;
+		}
+	}
+	add_command_chunks(chunks, chunk::COMMAND_DEFINITIONS, full_interface.commands);
+	add_command_chunks(chunks, chunk::COMMAND_LOADS, full_interface.commands);
+	FOREACH_CONST (iter, m.extension_interfaces, extension_interfaces_type) {
+		if (iter->second->commands.size()) {
+			chunk &c = add_chunk(chunks, chunk::EXTENSION_CHECK, iter->second);
+			c.name = iter->first;
+			c.prepared = use_prepared ? find_prepared(m.prepared.extension_checks, iter->first) : NULL;
+		}
+	}
+	FOREACH_CONST (iter, m.feature_interfaces, feature_interfaces_type) {
+		if (iter->first > min_version && iter->second->commands.size()) {
+			chunk &c = add_chunk(chunks, chunk::FEATURE_CHECK, iter->second);
+			c.version = iter->first;
+		}
+	}
+	format_chunks(e, chunks, opts.threads);
+	size_t next = 0;
+
+	header_file.print("#ifndef GL_BINDIFY_%s_H\n", m.api_name);
+	header_file.print("#define GL_BINDIFY_%s_H\n", m.api_name);
+
+	header_file.print("#ifdef __cplusplus\n");
+	header_file.print("extern \"C\" {\n");
+	header_file.print("#endif\n");
+
+	switch (m.api) {
+	case API_GLX:
+		header_file.print("#include <X11/Xlib.h>\n");
+		header_file.print("#include <X11/Xutil.h>\n");
+		break;
+	case API_WGL:
+		header_file.print("#include <windows.h>\n");
+		break;
+	default:
+		break;
+	}
+	header_file.print("#include <stdint.h>\n");
+	header_file.print("#include <stddef.h>\n");
+	header_file.print("#include <string.h>\n");
+	header_file.print("#include <stdbool.h>\n");
+
+	//
+	//We need to include these typedefs even for glx and wgl since they are referenced there without being defined
+	//
+	header_file.indent_print("#ifndef GLBINDIFY_COMMON_GL_TYPEDEFS\n");
+	header_file.indent_print("#define GLBINDIFY_COMMON_GL_TYPEDEFS\n");
+	header_file.indent_print("typedef unsigned int GLenum;\n");
+	header_file.indent_print("typedef unsigned char GLboolean;\n");
+	header_file.indent_print("typedef unsigned int GLbitfield;\n");
+	header_file.indent_print("typedef signed char GLbyte;\n");
+	header_file.indent_print("typedef short GLshort;\n");
+	header_file.indent_print("typedef int GLint;\n");
+	header_file.indent_print("typedef unsigned char GLubyte;\n");
+	header_file.indent_print("typedef unsigned short GLushort;\n");
+	header_file.indent_print("typedef unsigned int GLuint;\n");
+	header_file.indent_print("typedef int GLsizei;\n");
+	header_file.indent_print("typedef float GLfloat;\n");
+	header_file.indent_print("typedef double GLdouble;\n");
+	header_file.indent_print("typedef ptrdiff_t GLintptr;\n");
+	header_file.indent_print("typedef ptrdiff_t GLsizeiptr;\n");
+
+	header_file.indent_print("#endif\n");
+	header_file.indent_print("#ifndef %s_%sVERSION\n", macro_prefix, enumeration_prefix);
+	header_file.indent_print("#define %s_%sVERSION %d\n", macro_prefix, enumeration_prefix, min_version);
+	header_file.indent_print("#endif\n");
+
+	if (m.api == API_EGL) {
+		header_file.indent_print("#include <eglplatform.h>\n");
+		header_file.indent_print("#include <khrplatform.h>\n");
+	}
+
+	//
+	//Every type of the API, or with used_types only those something in the
+	//bindings uses. Either way in registry order, so each follows those it
+	//depends on.
+	//
+	type_marker types(m.types);
+	if (opts.used_types) {
+		FOREACH_CONST (iter, full_interface.commands, commands_type)
+			types.use_command(*iter->second);
+		FOREACH_CONST (iter, full_interface.enums, enums_type) {
+			enum_str_map_type::const_iterator str = m.enum_str_map.find(*iter);
+			if (str != m.enum_str_map.end())
+				types.use_identifiers(str->second, strlen(str->second));
+		}
+		types.close();
+	}
+	for (unsigned int i = 0; i < m.types.size(); i++) {
+		if (!opts.used_types || types.used[i])
+			header_file.indent_print("%s\n", m.types[i].decl.c_str());
+	}
+
+	if (opts.enums != ENUM_STYLE_MACRO)
+		e.print_enum_declarations(base_interface, header_file);
+	e.print_interface_declaration(&base_interface, header_file);
+	if (split) {
+		header_file.indent_print("\n");
+		next = write_split_chunks(e, header_file, chunks, next, chunk::FEATURE_DECLARATION, split_directory, *split);
+		header_file.indent_print("\n");
+		next = write_split_chunks(e, header_file, chunks, next, chunk::EXTENSION_DECLARATION, split_directory, *split);
+	} else {
+		next = write_chunks(header_file, chunks, next, chunk::FEATURE_DECLARATION);
+		header_file.indent_print("\n");
+		next = write_chunks(header_file, chunks, next, chunk::EXTENSION_DECLARATION);
+	}
+
+	header_file.indent_print("\n");
+	header_file.indent_print("bool %s_%s_init(int maj, int min);\n",  prefix, m.variant_name);
+
+	header_file.indent_print("\n");
+	header_file.print("#ifdef __cplusplus\n");
+	header_file.print("}\n"); //extern "C" {
+	header_file.print("#endif\n");
+
+	header_file.print("#endif\n");
+
+	source_file.print("#ifndef _WIN32\n");
+
+	if (m.api != API_EGL && m.api != API_GLX)
+		source_file.print("#ifdef %s_USE_EGL\n", macro_prefix);
+	if (m.api != API_GLX) {
+		source_file.print("extern void (*eglGetProcAddress(const unsigned char *))(void);\n");
+		source_file.print("static inline void *LoadProcAddress(const char *name) { return eglGetProcAddress((const unsigned char *)name); }\n");
+	}
+	if (m.api != API_EGL && m.api != API_GLX)
+		source_file.print("#else\n");
+	if (m.api != API_EGL) {
+		source_file.print("extern void (*glXGetProcAddress(const unsigned char *))(void);\n");
+		source_file.print("static inline void *LoadProcAddress(const char *name) { return glXGetProcAddress((const unsigned char *)name); }\n");
+	}
+	if (m.api != API_EGL && m.api != API_GLX)
+		source_file.print("#endif\n");
+	source_file.print("#include <stdio.h>\n");
+	source_file.print("#else\n");
+	source_file.print("#include <windows.h>\n");
+	source_file.print("#include <wingdi.h>\n");
+	source_file.print("#include <stdio.h>\n");
+	source_file.print("static PROC LoadProcAddress(const char *name) {\n");
+	source_file.print("\tPROC addr = wglGetProcAddress((LPCSTR)name);\n");
+	source_file.print("\tif (addr) return addr;\n");
+	source_file.print("\telse return (PROC)GetProcAddress(GetModuleHandleA(\"OpenGL32.dll\"), (LPCSTR)name);\n");
+	source_file.print("}\n");
+	source_file.print("#endif\n");
+	source_file.print("#define %s_%sVERSION %d\n", macro_prefix, enumeration_prefix, max_version);
+
+	FOREACH_CONST (iter, m.extension_interfaces, extension_interfaces_type) {
+		source_file.indent_print("#undef %s_ENABLE_%s%s\n", macro_prefix, enumeration_prefix, iter->first);
+		source_file.indent_print("#define %s_ENABLE_%s%s\n", macro_prefix, enumeration_prefix, iter->first);
+	}
+
+	source_file.print("#include \"%s\"\n", header_name);
+
+	source_file.indent_print("\n");
+	next = write_chunks(source_file, chunks, next, chunk::COMMAND_DEFINITIONS);
+
+	source_file.indent_print("\n");
+	FOREACH_CONST (iter, m.extension_interfaces, extension_interfaces_type) {
+		source_file.indent_print("bool %s_%s%s = %s;\n",
+				macro_prefix,
+				enumeration_prefix,
+				iter->first,
+				is_gl_api ? "false" : "true");
+	}
+
+#if USE_GPERF
+	if (is_gl_api)
+		e.print_extension_hash(source_file);
+#endif
+
+	source_file.indent_print("\n");
+	source_file.indent_print("bool %s_%s_init(int maj, int min)\n", prefix, m.variant_name);
+	source_file.indent_print("{\n");
+	source_file.increase_indent();
+	source_file.indent_print("int req_version = maj * 10 + min;\n");
+	if (is_gl_api) {
+		source_file.indent_print("int actual_maj, actual_min, actual_version, i;\n");
+		source_file.indent_print("int num_extensions;\n");
+	}
+	source_file.indent_print("if (req_version < %d) return false;\n", min_version);
+	source_file.indent_print("if (req_version > %d) return false;\n", max_version);
+
+	next = write_chunks(source_file, chunks, next, chunk::COMMAND_LOADS);
+
+	if (is_gl_api) {
+		source_file.indent_print("\n");
+		source_file.indent_print("if (!glGetIntegerv || !glGetStringi) return false;\n");
+		source_file.indent_print("glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);\n");
+		source_file.indent_print("glGetIntegerv(GL_MAJOR_VERSION, &actual_maj);\n");
+		source_file.indent_print("glGetIntegerv(GL_MINOR_VERSION, &actual_min);\n");
+		source_file.indent_print("actual_version = actual_maj * 10 + actual_min;\n");
+		source_file.indent_print("if (actual_version < req_version) return false;\n");
+		source_file.indent_print("for (i = 0; i < num_extensions; i++) {\n");
+		source_file.indent_print("\tconst char *extname = (const char *)glGetStringi(GL_EXTENSIONS, i);\n");
+#if USE_GPERF
+		source_file.indent_print("\tstruct extension_match *match = %s_find_extension(extname, strlen(extname));\n", prefix);
+		source_file.indent_print("\tif (match)\n");
+		source_file.indent_print("\t\t*match->support_flag = true;\n");
+#else
+		FOREACH_CONST (iter, m.extension_interfaces, extension_interfaces_type) {
+			source_file.indent_print("\tif (!strcmp(extname, \"%s%s\")) {\n", enumeration_prefix, iter->first);
+			source_file.indent_print("\t\t%s_%s%s = true;\n", macro_prefix, enumeration_prefix, iter->first);
+			source_file.indent_print("\t\tcontinue;\n");
+			source_file.indent_print("\t}\n");
+		}
+#endif
+		source_file.indent_print("}\n");
+	}
+
+	next = write_chunks(source_file, chunks, next, chunk::EXTENSION_CHECK);
+
+	source_file.indent_print("\n");
+	source_file.indent_print("return ");
+	e.print_interface_load_check(&base_interface, source_file);
+
+	write_chunks(source_file, chunks, next, chunk::FEATURE_CHECK);
+	source_file.print(";\n");
+	source_file.decrease_indent();
+	source_file.indent_print("}\n"); //init()
+}
+
+void bindify(const registry &reg, const options &opts, output_sink &header, output_sink &source)
+{
+	write_bindings(reg, opts, header, source, NULL);
+}
+
+void bindify_split(const registry &reg, const options &opts, output_sink &header, output_sink &source,
+		header_set &headers)
+{
+	//Hoisted enums would only be declared through the main header
+	options split_opts = opts;
+	split_opts.enums = ENUM_STYLE_MACRO;
+	write_bindings(reg, split_opts, header, source, &headers);
+}
+
+}
@@ -0,0 +1,104 @@
+#ifndef BUILTIN_REGISTRY_H
+#define BUILTIN_REGISTRY_H
+
+#include <stdint.h>
+
+//
+//Static tables holding a parsed registry for one API. They are written by
+//'glbindify --dump-registry' and compiled into glbindify when it is
+//configured with --enable-builtin-registry.
+//
+//Commands refer to a range of the param table, enumerations to a range of
+//the enum table and interfaces to a range of the interface item table.
+//
+
+struct builtin_param {
+	const char *type;
+	const char *name;
+	unsigned int decl_offset;
+	unsigned int decl_length;
+};
+
+struct builtin_command {
+	const char *name;
+	const char *type;
+	const char *type_decl;
+	const char *signature;
+	unsigned int first_param;
+	unsigned int num_params;
+};
+
+struct builtin_enum {
+	const char *name;
+	uint64_t value;
+	int suffix;
+};
+
+struct builtin_enum_str {
+	const char *name;
+	const char *value;
+};
+
+struct builtin_type {
+	const char *name;
+	const char *requires;
+	const char *decl;
+};
+
+struct builtin_enumeration {
+	const char *name;
+	unsigned int first_enum;
+	unsigned int num_enums;
+};
+
+enum builtin_item_list {
+	BUILTIN_ENUM,
+	BUILTIN_COMMAND,
+	BUILTIN_REMOVED_ENUM,
+	BUILTIN_REMOVED_COMMAND
+};
+
+struct builtin_interface_item {
+	int list;
+	const char *name;
+};
+
+struct builtin_interface {
+	int version;
+	const char *name;
+	unsigned int first_item;
+	unsigned int num_items;
+};
+
+struct builtin_registry {
+	const char *api_name;
+	const char *xml_name;
+
+	//FNV-1a hash of the registry file the tables were built from
+	unsigned int xml_hash_hi;
+	unsigned int xml_hash_lo;
+
+	const builtin_command *commands;
+	unsigned int num_commands;
+	const builtin_param *params;
+
+	const builtin_enumeration *enumerations;
+	unsigned int num_enumerations;
+	const builtin_enum *enums;
+	const builtin_enum_str *enum_strs;
+	unsigned int num_enum_strs;
+
+	const builtin_type *types;
+	unsigned int num_types;
+
+	const builtin_interface *features;
+	unsigned int num_features;
+	const builtin_interface *extensions;
+	unsigned int num_extensions;
+	const builtin_interface_item *items;
+};
+
+extern const builtin_registry *const g_builtin_registries[];
+extern const unsigned int g_num_builtin_registries;
+
+#endif
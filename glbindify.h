@@ -0,0 +1,170 @@
+#ifndef GLBINDIFY_H
+#define GLBINDIFY_H
+
+//
+//libglbindify: generate C bindings for a khronos API registry in process
+//
+//A registry is parsed once for one API and can then be passed to bindify()
+//any number of times with different options. Generated text is handed to
+//output sinks, so bindings can be kept in memory or written anywhere.
+//
+//Example:
+//
+//	glbindify::registry *reg = glbindify::registry::load_file("gl", "gl.xml");
+//	glbindify::options opts;
+//	opts.prefix = "myapp";
+//	glbindify::string_sink header, source;
+//	glbindify::bindify(*reg, opts, header, source);
+//	delete reg;
+//
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+
+struct builtin_registry;
+
+namespace glbindify {
+
+class output_sink {
+public:
+	virtual ~output_sink() {}
+	virtual void write(const char *data, size_t size) = 0;
+};
+
+class string_sink : public output_sink {
+public:
+	std::string str;
+	virtual void write(const char *data, size_t size) { str.append(data, size); }
+};
+
+class file_sink : public output_sink {
+	FILE *m_file;
+public:
+	file_sink(FILE *file) : m_file(file) {}
+	virtual void write(const char *data, size_t size) { fwrite(data, 1, size, m_file); }
+};
+
+//
+//Receives the headers bindify_split() writes besides the main one
+//
+class header_set {
+public:
+	virtual ~header_set() {}
+
+	//'name' is a path relative to the directory of the main header
+	virtual void add(const std::string &name, const std::string &contents) = 0;
+};
+
+//
+//How the header declares enum constants
+//
+enum enum_style {
+	//#undef and #define in every feature and extension that has the enum
+	ENUM_STYLE_MACRO,
+
+	//Anonymous C enums, one per registry group. Values that are not an
+	//int, and those that are not a number, are still macros.
+	ENUM_STYLE_ENUM,
+
+	//static const variables of the type the value has as a C literal.
+	//Values that are not a number are still macros.
+	ENUM_STYLE_CONST
+};
+
+struct options {
+	//Namespace for the bindings. This is the first part of the name of
+	//every function and macro. The upper case version is used for macros.
+	const char *prefix;
+
+	//Name the generated source file uses to include the header. Defaults
+	//to "<variant>.h", see registry::variant_name().
+	const char *header_name;
+
+	//Number of threads formatting the bindings, 0 for one per processor
+	unsigned int threads;
+
+	//With anything but ENUM_STYLE_MACRO each enum is declared once, ahead
+	//of the features and extensions. The declarations are grouped by the
+	//features and extensions that have them, so they are conditional on
+	//the same macros. Other headers defining the same enums as macros
+	//can't be included before the bindings.
+	enum_style enums;
+
+	//Only declare the types the commands and enums of the bindings use,
+	//instead of every type the registry has for the API. Code that uses
+	//other types, such as GLvoid or GLhalf, has to declare them itself.
+	bool used_types;
+
+	options() : prefix("glb"), header_name(NULL), threads(1), enums(ENUM_STYLE_MACRO), used_types(false) {}
+};
+
+class registry {
+public:
+	struct model;
+
+	//Load the registry for 'api_name' ('gl', 'gles2', 'egl', 'glx' or 'wgl')
+	//from an XML file or buffer. Returns NULL and sets 'error' on failure.
+	//With more than one thread the top level sections of the registry are
+	//parsed concurrently, 0 uses one thread per processor.
+	//
+	//With 'pipeline' set and a single parse thread, the declarations of each
+	//feature and extension are formatted for those options on a second
+	//thread as soon as they are modelled, and bindify() reuses them.
+	static registry *load_file(const char *api_name, const char *filename, std::string *error = NULL,
+			unsigned int threads = 1, const options *pipeline = NULL);
+	static registry *load_buffer(const char *api_name, const char *data, size_t size, std::string *error = NULL,
+			unsigned int threads = 1, const options *pipeline = NULL);
+
+	//Load a registry from tables written by dump_registry_tables()
+	static registry *load_tables(const builtin_registry &tables);
+
+	//Registry file name for an API or NULL if the API is not known
+	static const char *xml_name(const char *api_name);
+
+	~registry();
+
+	const char *api_name() const;
+	const char *variant_name() const;
+	const char *print_name() const;
+
+	//Lowest version the generated bindings support, as major * 10 + minor
+	int min_version() const;
+
+	//FNV-1a hash of the registry XML
+	uint64_t hash() const;
+
+	//Time spent parsing the XML and building the model, in milliseconds
+	double parse_time() const;
+	double build_time() const;
+
+	const model &get_model() const { return *m_model; }
+private:
+	model *m_model;
+
+	registry(model *model);
+	registry(const registry &);
+	registry &operator=(const registry &);
+};
+
+//Write the header and source of the bindings for 'reg' to the sinks
+void bindify(const registry &reg, const options &opts, output_sink &header, output_sink &source);
+
+//Like bindify(), but each feature after the lowest supported version and
+//each extension is declared in a header of its own, in a directory named
+//after the main header. A version's header includes the one before it and
+//an extension's header includes the main header, so a source file only
+//needs to include the versions and extensions it uses. The main header
+//still includes them when GLB_GL_VERSION and GLB_ENABLE_* ask for them.
+//Enums are always macros.
+void bindify_split(const registry &reg, const options &opts, output_sink &header, output_sink &source,
+		header_set &headers);
+
+//Write the model of 'reg' as C++ static tables that load_tables() accepts.
+//All table names start with 'sym'.
+void dump_registry_tables(const registry &reg, const char *sym, output_sink &out);
+
+}
+
+#endif
@@ -0,0 +1,1822 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <errno.h>
+#include <ctype.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <deque>
+
+#include "tinyxml2.h"
+#include "builtin_registry.h"
+#include "registry.h"
+#include "thread.h"
+#include "writer.h"
+
+using namespace tinyxml2;
+
+namespace glbindify {
+
+double time_ms()
+{
+#if defined(_WIN32)
+	LARGE_INTEGER freq, count;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (double)count.QuadPart * 1000.0 / (double)freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
+
+uint64_t fnv1a_64(const void *data, size_t size, uint64_t hash)
+{
+	const unsigned char *p = (const unsigned char *)data;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= p[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+//
+//gl.xml fills about 14 chunks, so loading it takes few allocations, while
+//egl.xml, glx.xml and wgl.xml fit in one or two and leave little unused. Each
+//parse thread starts a chunk of its own.
+//
+static const size_t MODEL_ARENA_CHUNK = 64 * 1024;
+
+model_arena::~model_arena()
+{
+	FOREACH (iter, m_chunks, std::vector<char *>)
+		delete [] *iter;
+}
+
+void *model_arena::alloc(size_t size)
+{
+	size = (size + 7) & ~(size_t)7;
+	if (size > m_left) {
+		//Anything too big for a chunk gets one of its own, and the
+		//current chunk is kept for what follows
+		if (size > MODEL_ARENA_CHUNK / 4) {
+			m_chunks.push_back(new char[size]);
+			return m_chunks.back();
+		}
+		m_chunks.push_back(new char[MODEL_ARENA_CHUNK]);
+		m_next = m_chunks.back();
+		m_left = MODEL_ARENA_CHUNK;
+	}
+	void *mem = m_next;
+	m_next += size;
+	m_left -= size;
+	return mem;
+}
+
+const char *model_arena::copy(const char *str, size_t length)
+{
+	char *mem = (char *)alloc(length + 1);
+	memcpy(mem, str, length);
+	mem[length] = '\0';
+	return mem;
+}
+
+void model_arena::adopt(model_arena &other)
+{
+	m_chunks.insert(m_chunks.end(), other.m_chunks.begin(), other.m_chunks.end());
+	other.m_chunks.clear();
+	other.m_next = NULL;
+	other.m_left = 0;
+}
+
+bool read_file(const char *filename, std::string *contents)
+{
+	FILE *file = fopen(filename, "rb");
+	if (!file)
+		return false;
+	char buf[65536];
+	size_t count;
+	contents->clear();
+	while ((count = fread(buf, 1, sizeof(buf), file)) > 0)
+		contents->append(buf, count);
+	bool ok = !ferror(file);
+	fclose(file);
+	return ok;
+}
+
+#ifdef HAVE_ZLIB
+//
+//Inflate the gzip stream in 'file' onto the end of 'contents' as it is read.
+//'buf' holds the first 'count' bytes of the stream and is reused for the
+//rest. Concatenated gzip members are inflated one after another.
+//
+static bool inflate_file(FILE *file, char *buf, size_t size, size_t count, std::string *contents)
+{
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	if (inflateInit2(&zs, 15 + 16) != Z_OK)
+		return false;
+	bool ended = false;
+	bool ok = true;
+	while (ok && count > 0) {
+		zs.next_in = (Bytef *)buf;
+		zs.avail_in = count;
+		while (ok && (zs.avail_in || (!ended && !zs.avail_out))) {
+			if (ended) {
+				inflateReset(&zs);
+				ended = false;
+			}
+			size_t used = contents->size();
+			contents->resize(used + size);
+			zs.next_out = (Bytef *)&(*contents)[used];
+			zs.avail_out = size;
+			int ret = inflate(&zs, Z_NO_FLUSH);
+			contents->resize(used + size - zs.avail_out);
+			if (ret == Z_STREAM_END)
+				ended = true;
+			else if (ret != Z_OK && ret != Z_BUF_ERROR)
+				ok = false;
+		}
+		count = fread(buf, 1, size, file);
+	}
+	inflateEnd(&zs);
+	return ok && ended && !ferror(file);
+}
+#endif
+
+bool read_registry(const char *filename, std::string *contents, std::string *error)
+{
+	bool use_stdin = !strcmp(filename, "-");
+	FILE *file = use_stdin ? stdin : fopen(filename, "rb");
+	if (!file) {
+		*error = std::string("Error reading khronos registry file ") + filename + ": " + strerror(errno);
+		return false;
+	}
+#if defined(_WIN32)
+	if (use_stdin)
+		_setmode(_fileno(stdin), _O_BINARY);
+#endif
+	char buf[65536];
+	size_t count = fread(buf, 1, sizeof(buf), file);
+	bool ok;
+	contents->clear();
+	if (count >= 2 && (unsigned char)buf[0] == 0x1f && (unsigned char)buf[1] == 0x8b) {
+#ifdef HAVE_ZLIB
+		ok = inflate_file(file, buf, sizeof(buf), count, contents);
+		if (!ok)
+			*error = std::string("Error decompressing khronos registry file ") + filename;
+#else
+		ok = false;
+		*error = std::string("Khronos registry file ") + filename +
+			" is compressed and glbindify was built without zlib";
+#endif
+	} else {
+		while (count > 0) {
+			contents->append(buf, count);
+			count = fread(buf, 1, sizeof(buf), file);
+		}
+		ok = !ferror(file);
+		if (!ok)
+			*error = std::string("Error reading khronos registry file ") + filename + ": " + strerror(errno);
+	}
+	if (!use_stdin)
+		fclose(file);
+	return ok;
+}
+
+//
+//Elements the visitors look at. tinyxml2 tags each element with its index in
+//tag_names as it is parsed, so elements are told apart without strcmp().
+//
+enum tag {
+	TAG_OTHER,
+	TAG_REGISTRY,
+	TAG_TYPES,
+	TAG_TYPE,
+	TAG_ENUMS,
+	TAG_ENUM,
+	TAG_COMMANDS,
+	TAG_COMMAND,
+	TAG_PROTO,
+	TAG_PARAM,
+	TAG_PTYPE,
+	TAG_NAME,
+	TAG_FEATURE,
+	TAG_EXTENSIONS,
+	TAG_EXTENSION,
+	TAG_REQUIRE,
+	TAG_REMOVE,
+	NUM_TAGS
+};
+
+static const char *const tag_names[NUM_TAGS] = {
+	"",
+	"registry",
+	"types",
+	"type",
+	"enums",
+	"enum",
+	"commands",
+	"command",
+	"proto",
+	"param",
+	"ptype",
+	"name",
+	"feature",
+	"extensions",
+	"extension",
+	"require",
+	"remove"
+};
+
+//
+//Attributes the visitors read, found by index in attribute_names
+//
+enum attribute {
+	ATTR_OTHER,
+	ATTR_API,
+	ATTR_NAME,
+	ATTR_VALUE,
+	ATTR_GROUP,
+	ATTR_PROFILE,
+	ATTR_SUPPORTED,
+	ATTR_TYPE,
+	ATTR_REQUIRES,
+	NUM_ATTRS
+};
+
+static const char *const attribute_names[NUM_ATTRS] = {
+	"",
+	"api",
+	"name",
+	"value",
+	"group",
+	"profile",
+	"supported",
+	"type",
+	"requires"
+};
+
+static inline int parent_tag(const XMLFrozenNode &node)
+{
+	return node.Parent().TagId();
+}
+
+static inline bool tag_stack_test(const XMLFrozenNode &elem, int tag, int parent)
+{
+	return elem.TagId() == tag && parent_tag(elem) == parent;
+}
+
+static inline bool parent_tag_stack_test(const XMLFrozenNode &node, int tag, int parent)
+{
+	return tag_stack_test(node.Parent(), tag, parent);
+}
+
+//
+//Append the text of a node straight from the parsed document
+//
+static inline void append_text(std::string &str, const XMLFrozenNode &text)
+{
+	size_t length;
+	const char *value = text.Value(&length);
+	str.append(value, length);
+}
+
+//
+//Copy the text of a node into the model
+//
+static inline const char *copy_text(registry::model &m, const XMLFrozenNode &text)
+{
+	size_t length;
+	const char *value = text.Value(&length);
+	return m.arena.copy(value, length);
+}
+
+//
+//Add 'name' to a set of enums, copied into the model if it is new to the set.
+//This costs a few copies of the same name across interfaces, but looking it
+//up in the enums of the model first takes longer than copying it.
+//
+static void add_enum_name(registry::model &m, enums_type &enums, const char *name)
+{
+	enums_type::iterator iter = enums.lower_bound(name);
+	if (iter == enums.end() || strcmp(*iter, name))
+		enums.insert(iter, m.arena.copy(name));
+}
+
+//
+//Entry for 'name' in one of the maps of the model. As with operator[] a
+//missing entry is added with an empty value, but with a name owned by the
+//model.
+//
+template <class M>
+static typename M::iterator model_entry(registry::model &m, M &map, const char *name)
+{
+	typename M::iterator iter = map.lower_bound(name);
+	if (iter == map.end() || strcmp(iter->first, name))
+		iter = map.insert(iter, std::make_pair(m.arena.copy(name), typename M::mapped_type()));
+	return iter;
+}
+
+registry::model::model() :
+	api(API_GL),
+	api_name(NULL),
+	variant_name(NULL),
+	command_prefix(NULL),
+	enumeration_prefix(NULL),
+	api_print_name(NULL),
+	xml_name(NULL),
+	min_version(10),
+	xml_hash(0),
+	parse_time(0),
+	build_time(0),
+	pipeline(NULL)
+{
+	common_gl_typedefs.insert("GLenum");
+	common_gl_typedefs.insert("GLboolean");
+	common_gl_typedefs.insert("GLbitfield");
+	common_gl_typedefs.insert("GLbyte");
+	common_gl_typedefs.insert("GLshort");
+	common_gl_typedefs.insert("GLint");
+	common_gl_typedefs.insert("GLubyte");
+	common_gl_typedefs.insert("GLushort");
+	common_gl_typedefs.insert("GLuint");
+	common_gl_typedefs.insert("GLsizei");
+	common_gl_typedefs.insert("GLfloat");
+	common_gl_typedefs.insert("GLdouble");
+	common_gl_typedefs.insert("GLintptr");
+	common_gl_typedefs.insert("GLsizeiptr");
+}
+
+registry::model::~model()
+{
+	FOREACH (iter, commands, commands_type)
+		arena.destroy(iter->second);
+	FOREACH (iter, enumerations, enumerations_type)
+		arena.destroy(*iter);
+	FOREACH (iter, feature_interfaces, feature_interfaces_type)
+		arena.destroy(iter->second);
+	FOREACH (iter, extension_interfaces, extension_interfaces_type)
+		arena.destroy(iter->second);
+}
+
+bool registry::model::is_command_in_namespace(const char **name) const
+{
+	if (strstr(*name, command_prefix)) {
+		*name = *name + strlen(command_prefix);
+		return true;
+	} else {
+		return false;
+	}
+}
+
+bool registry::model::is_enum_in_namespace(const char **name) const
+{
+	if (strstr(*name, enumeration_prefix) == *name) {
+		*name = *name + strlen(enumeration_prefix);
+		return true;
+	} else {
+		return false;
+	}
+}
+
+//
+//Set up the API description of a model. Returns false if the API is not
+//recognized.
+//
+static bool select_api(registry::model *m, const char *api_name)
+{
+	m->api_name = api_name;
+	if (!strcmp(api_name, "wgl")) {
+		m->api = API_WGL;
+		m->command_prefix = "wgl";
+		m->enumeration_prefix = "WGL_";
+		m->api_print_name = "WGL";
+		m->variant_name = "wgl";
+		m->xml_name = "wgl.xml";
+		m->min_version = 10;
+	} else if (!strcmp(api_name, "glx")) {
+		m->api = API_GLX;
+		m->command_prefix = "glX";
+		m->enumeration_prefix = "GLX_";
+		m->variant_name = "glx";
+		m->xml_name = "glx.xml";
+		m->api_print_name = "glX";
+		m->min_version = 14;
+	} else if (!strcmp(api_name, "gl")) {
+		m->api = API_GL;
+		m->command_prefix = "gl";
+		m->enumeration_prefix = "GL_";
+		m->api_print_name = "OpenGL";
+		m->variant_name = "glcore";
+		m->xml_name = "gl.xml";
+		m->min_version = 32;
+	} else if (!strcmp(api_name, "egl")) {
+		m->api = API_EGL;
+		m->command_prefix = "egl";
+		m->enumeration_prefix = "EGL_";
+		m->api_print_name = "EGL";
+		m->variant_name = "egl";
+		m->xml_name = "egl.xml";
+		m->min_version = 10;
+	} else if (!strcmp(api_name, "gles2")) {
+		m->api = API_GLES2;
+		m->command_prefix = "gl";
+		m->enumeration_prefix = "GL_";
+		m->api_print_name = "GLES2";
+		m->variant_name = "gles2";
+		m->xml_name = "gl.xml";
+		m->min_version = 20;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+template <class T>
+class data_builder_visitor : public XMLFrozenVisitor
+{
+protected:
+	T *m_data;
+	registry::model &m_registry;
+private:
+	const XMLFrozenNode m_root;
+
+	virtual bool visit(const XMLFrozenNode &/*text*/) { return true; }
+	bool Visit(const XMLFrozenNode &text) { return visit(text); }
+
+	virtual bool visit_begin(const XMLFrozenNode &/*elem*/) { return true; }
+	virtual bool visit_enter(const XMLFrozenNode &/*elem*/) { return true; }
+
+	bool VisitEnter(const XMLFrozenNode &elem)
+	{
+		if (elem == m_root) {
+			return visit_begin(elem);
+		} else {
+			return visit_enter(elem);
+		}
+	}
+
+	virtual bool visit_end(const XMLFrozenNode &/*elem*/) { return true; }
+	virtual bool visit_exit(const XMLFrozenNode &/*elem*/) { return true; }
+
+	bool VisitExit(const XMLFrozenNode &elem)
+	{
+		if (elem == m_root) {
+			return visit_end(elem);
+		} else {
+			return visit_exit(elem);
+		}
+	}
+public:
+	data_builder_visitor(registry::model &registry, const XMLFrozenNode &root) :
+		m_data(registry.arena.create<T>()),
+		m_registry(registry),
+		m_root(root)
+	{
+	}
+
+	T *build()
+	{
+		m_root.Accept(this);
+		return m_data;
+	}
+};
+
+class command_visitor : public data_builder_visitor<command>
+{
+	std::string &m_signature;
+
+	void append_param_text(const XMLFrozenNode &text)
+	{
+		append_text(m_signature, text);
+		command::param &param = m_data->params.back();
+		param.decl_length = m_signature.size() - param.decl_offset;
+	}
+
+	virtual bool visit(const XMLFrozenNode &text)
+	{
+		if (!m_data)
+			return false;
+
+		if (parent_tag(text) == TAG_PARAM) {
+			append_param_text(text);
+		} else if (parent_tag_stack_test(text, TAG_NAME, TAG_PARAM)) {
+			m_data->params.back().name = copy_text(m_registry, text);
+		} else if (parent_tag_stack_test(text, TAG_PTYPE, TAG_PARAM)) {
+			m_data->params.back().type = copy_text(m_registry, text);
+			append_param_text(text);
+		} else if (parent_tag(text) == TAG_PROTO) {
+			append_text(m_data->type_decl, text);
+		} else if (parent_tag_stack_test(text, TAG_NAME, TAG_PROTO)) {
+			const char *command_name = text.Value();
+			if (m_registry.is_command_in_namespace(&command_name)) {
+				m_data->name = m_registry.arena.copy(command_name);
+				return true;
+			} else {
+				m_registry.arena.destroy(m_data);
+				m_data = NULL;
+				return false;
+			}
+		} else if (parent_tag_stack_test(text, TAG_PTYPE, TAG_PROTO)) {
+			m_data->type = copy_text(m_registry, text);
+			append_text(m_data->type_decl, text);
+		}
+		return true;
+	}
+
+	virtual bool visit_enter(const XMLFrozenNode &elem)
+	{
+		if (!m_data)
+			return false;
+
+		switch (elem.TagId()) {
+		case TAG_PROTO:
+			return true;
+		case TAG_PARAM: {
+			if (m_data->params.size())
+				m_signature += ", ";
+			command::param param;
+			param.decl_offset = m_signature.size();
+			m_data->params.push_back(param);
+			return true;
+		}
+		case TAG_PTYPE:
+		case TAG_NAME:
+			return parent_tag(elem) == TAG_PROTO || parent_tag(elem) == TAG_PARAM;
+		default:
+			return false;
+		}
+	}
+public:
+	//
+	//'signature' is scratch space for the parameter list, kept by the
+	//caller so its buffer is reused from one command to the next
+	//
+	command_visitor(registry::model &registry, const XMLFrozenNode &tag, std::string &signature) :
+		data_builder_visitor<command>(registry, tag),
+		m_signature(signature)
+	{
+		m_signature.clear();
+	}
+
+	command *build()
+	{
+		data_builder_visitor<command>::build();
+		if (m_data) {
+			m_data->signature = m_registry.arena.copy(m_signature.data(), m_signature.size());
+			m_data->signature_length = m_signature.size();
+		}
+		return m_data;
+	}
+};
+
+//
+//Parse a decimal or 0x prefixed hexadecimal enum value with an optional u or
+//ull suffix. The registry's 'type' attribute, if any, sets the suffix too.
+//Negative values wrap to 32 bits, as GLenum does. Returns false for anything
+//else, such as casts, which are kept as text.
+//
+static bool parse_enum_value(const char *str, const char *type, enum_value *val)
+{
+	const char *p = str;
+	bool negative = *p == '-';
+	if (negative)
+		p++;
+	uint64_t value = 0;
+	const char *digits;
+	if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+		p += 2;
+		digits = p;
+		for (;; p++) {
+			unsigned int digit;
+			if (*p >= '0' && *p <= '9')
+				digit = *p - '0';
+			else if ((*p | 0x20) >= 'a' && (*p | 0x20) <= 'f')
+				digit = (*p | 0x20) - 'a' + 10;
+			else
+				break;
+			if (value >> 60)
+				return false;
+			value = value << 4 | digit;
+		}
+	} else {
+		digits = p;
+		for (; *p >= '0' && *p <= '9'; p++) {
+			unsigned int digit = *p - '0';
+			if (value > (~(uint64_t)0 - digit) / 10)
+				return false;
+			value = value * 10 + digit;
+		}
+	}
+	if (p == digits)
+		return false;
+
+	int suffix = ENUM_SUFFIX_NONE;
+	if (*p == 'u' || *p == 'U') {
+		p++;
+		suffix = ENUM_SUFFIX_U;
+		if ((p[0] == 'l' || p[0] == 'L') && p[1] == p[0]) {
+			p += 2;
+			suffix = ENUM_SUFFIX_ULL;
+		}
+	}
+	if (*p)
+		return false;
+
+	if (type && !strcmp(type, "u"))
+		suffix = ENUM_SUFFIX_U;
+	else if (type && !strcmp(type, "ull"))
+		suffix = ENUM_SUFFIX_ULL;
+	val->value = negative ? (uint32_t)(0u - (uint32_t)value) : value;
+	val->suffix = suffix;
+	return true;
+}
+
+class enumeration_visitor : public data_builder_visitor<enumeration>
+{
+	virtual bool visit_begin(const XMLFrozenNode &elem)
+	{
+		const char *group_c = elem.AttributeById(ATTR_GROUP);
+		if (group_c)
+			m_data->name = m_registry.arena.copy(group_c);
+		return true;
+	}
+
+	virtual bool visit_enter(const XMLFrozenNode &elem)
+	{
+		if (elem.TagId() == TAG_ENUM) {
+			const char *api = elem.AttributeById(ATTR_API);
+			if (api && strcmp(api, m_registry.api_name))
+				return false;
+			enum_value val;
+			const char *enumeration_name = elem.AttributeById(ATTR_NAME);
+			const char *value = elem.AttributeById(ATTR_VALUE);
+			if (m_registry.is_enum_in_namespace(&enumeration_name)) {
+				if (parse_enum_value(value, elem.AttributeById(ATTR_TYPE), &val)) {
+					enum_map_type::iterator iter = model_entry(m_registry, m_registry.enum_map, enumeration_name);
+					iter->second = val;
+					m_data->enum_map[iter->first] = val;
+				} else {
+					model_entry(m_registry, m_registry.enum_str_map, enumeration_name)->second =
+						m_registry.arena.copy(value);
+				}
+			}
+		}
+		return false;
+	}
+public:
+	enumeration_visitor(registry::model &registry, const XMLFrozenNode &tag) :
+		data_builder_visitor<enumeration>(registry, tag)
+	{
+	}
+};
+
+class interface_visitor : public XMLFrozenVisitor
+{
+	registry::model &m_registry;
+	const XMLFrozenNode m_root;
+	interface *m_interface;
+	bool VisitEnter(const XMLFrozenNode &elem)
+	{
+		if (elem == m_root) {
+			return true;
+		} else if ((elem.TagId() == TAG_REQUIRE || elem.TagId() == TAG_REMOVE) && elem.Parent() == m_root) {
+			const char *profile = elem.AttributeById(ATTR_PROFILE);
+			return m_registry.api != API_GL || !profile || !strcmp(profile, "core");
+		} else if (tag_stack_test(elem, TAG_ENUM, TAG_REQUIRE)) {
+			const char *enumeration_name = elem.AttributeById(ATTR_NAME);
+			if (m_registry.is_enum_in_namespace(&enumeration_name)) {
+				add_enum_name(m_registry, m_interface->enums, enumeration_name);
+				return true;
+			} else {
+				return false;
+			}
+		} else if (tag_stack_test(elem, TAG_ENUM, TAG_REMOVE)) {
+			const char *enumeration_name = elem.AttributeById(ATTR_NAME);
+			if (m_registry.is_enum_in_namespace(&enumeration_name)) {
+				add_enum_name(m_registry, m_interface->removed_enums, enumeration_name);
+				return true;
+			} else {
+				return false;
+			}
+		} else if (tag_stack_test(elem, TAG_COMMAND, TAG_REQUIRE)) {
+			const char *command_name = elem.AttributeById(ATTR_NAME);
+			if (m_registry.is_command_in_namespace(&command_name)) {
+				commands_type::iterator command = model_entry(m_registry, m_registry.commands, command_name);
+				m_interface->commands[command->first] = command->second;
+				return true;
+			} else {
+				return false;
+			}
+		} else if (tag_stack_test(elem, TAG_COMMAND, TAG_REMOVE)) {
+			const char *command_name = elem.AttributeById(ATTR_NAME);
+			if (m_registry.is_command_in_namespace(&command_name)) {
+				commands_type::iterator command = model_entry(m_registry, m_registry.commands, command_name);
+				m_interface->removed_commands[command->first] = command->second;
+				return true;
+			} else {
+				return false;
+			}
+		}
+		return false;
+	}
+public:
+	interface_visitor(registry::model &registry, const XMLFrozenNode &root, interface *interface) :
+		m_registry(registry), m_root(root), m_interface(interface) {}
+};
+
+class type_visitor :  public XMLFrozenVisitor
+{
+	registry::model &m_registry;
+	std::string m_type_decl;
+	const char *m_type_name;
+	const char *m_requires;
+
+	bool Visit(const XMLFrozenNode &text)
+	{
+		if (parent_tag(text) == TAG_TYPE) {
+			append_text(m_type_decl, text);
+		} else if (parent_tag_stack_test(text, TAG_NAME, TAG_TYPE)) {
+			append_text(m_type_decl, text);
+			m_type_name = text.Value();
+		}
+		return true;
+	}
+
+	bool VisitEnter(const XMLFrozenNode &elem)
+	{
+		if (tag_stack_test(elem, TAG_TYPE, TAG_TYPES)) {
+			const char *api = elem.AttributeById(ATTR_API);
+			m_requires = elem.AttributeById(ATTR_REQUIRES);
+			return !api || (api == m_registry.api_name);
+		} else if (tag_stack_test(elem, TAG_NAME, TAG_TYPE)) {
+			return true;
+		} else {
+			return false;
+		}
+	}
+
+	bool VisitExit(const XMLFrozenNode &elem)
+	{
+		if (m_type_name != NULL) {
+			if (elem.TagId() == TAG_TYPE) {
+				if (!m_registry.common_gl_typedefs.count(m_type_name)) {
+					type type;
+					type.name = m_registry.arena.copy(m_type_name);
+					if (m_requires)
+						type.requires = m_registry.arena.copy(m_requires);
+					type.decl = m_type_decl;
+					m_registry.common_gl_typedefs.insert(type.name);
+					m_registry.types.push_back(type);
+				}
+			}
+		}
+		return true;
+	}
+public:
+	type_visitor(registry::model &registry) : m_registry(registry), m_type_name(NULL), m_requires(NULL) {}
+};
+
+//
+//Formats the declarations of features and extensions on a second thread
+//while the rest of the registry is modelled. The visitor hands over each
+//interface once it is complete and does not touch it again.
+//
+class declaration_pipeline : public thread {
+	struct job {
+		int version;
+		const char *name;
+		const interface *iface;
+	};
+
+	registry::model &m_model;
+	mutex m_lock;
+	condition m_ready;
+	std::deque<job> m_jobs;
+	bool m_finished;
+	bool m_queued;
+	bool m_valid;
+
+	void run()
+	{
+		prepared_declarations &prepared = m_model.prepared;
+		const char *prefix = prepared.prefix.c_str();
+		enum_style enums = prepared.enums;
+		while (1) {
+			m_lock.lock();
+			while (m_jobs.empty() && !m_finished)
+				m_ready.wait(m_lock);
+			if (m_jobs.empty()) {
+				m_lock.unlock();
+				return;
+			}
+			job next = m_jobs.front();
+			m_jobs.pop_front();
+			m_lock.unlock();
+
+			if (next.name) {
+				format_extension_declaration(m_model, prefix, enums, next.name, *next.iface,
+						&prepared.extensions[next.name]);
+				if (next.iface->commands.size())
+					format_extension_check(m_model, prefix, next.name, *next.iface,
+							&prepared.extension_checks[next.name]);
+			} else {
+				format_feature_declaration(m_model, prefix, enums, next.version, *next.iface,
+						&prepared.features[next.version]);
+			}
+		}
+	}
+
+	void push(int version, const char *name, const interface *iface)
+	{
+		if (!m_valid)
+			return;
+
+		//Commands defined after the interface, if at all, are only resolved
+		//once the whole registry has been visited
+		FOREACH_CONST (iter, iface->commands, commands_type) {
+			if (!iter->second) {
+				discard();
+				return;
+			}
+		}
+		job job = { version, name, iface };
+		m_lock.lock();
+		m_jobs.push_back(job);
+		m_queued = true;
+		m_lock.unlock();
+		m_ready.signal();
+	}
+public:
+	declaration_pipeline(registry::model &model, const options &opts) :
+		m_model(model), m_finished(false), m_queued(false), m_valid(true)
+	{
+		m_model.prepared.prefix = opts.prefix;
+		m_model.prepared.enums = opts.enums;
+
+		//run() waits for jobs, so it can't run on this thread. Without a
+		//thread nothing is queued and bindify() formats everything.
+		if (!try_start())
+			m_valid = false;
+	}
+
+	void push_feature(int version, const interface *iface)
+	{
+		if (version > m_model.min_version)
+			push(version, NULL, iface);
+	}
+
+	void push_extension(const char *name, const interface *iface)
+	{
+		push(0, name, iface);
+	}
+
+	//
+	//Must be called before the visitor changes anything that was handed
+	//over or that formatting reads. If anything was queued it is waited for
+	//and thrown away, and bindify() formats everything itself.
+	//
+	void invalidate()
+	{
+		if (!m_valid || !m_queued)
+			return;
+		discard();
+	}
+
+	//
+	//Stop formatting and throw away anything already formatted
+	//
+	void discard()
+	{
+		finish();
+		m_valid = false;
+		m_model.prepared.valid = false;
+		m_model.prepared.features.clear();
+		m_model.prepared.extensions.clear();
+		m_model.prepared.extension_checks.clear();
+	}
+
+	//
+	//Wait for everything queued to be formatted
+	//
+	void finish()
+	{
+		m_lock.lock();
+		m_finished = true;
+		m_lock.unlock();
+		m_ready.signal();
+		join();
+		m_model.prepared.valid = m_valid;
+	}
+};
+
+//
+//Check for 'variant' in a '|' separated list. Sections may be visited on
+//several threads at once so this must not use strtok().
+//
+static bool is_supported(const char *supported, const char *variant)
+{
+	size_t len = strlen(variant);
+	const char *p = supported;
+	while (p) {
+		const char *end = strchr(p, '|');
+		size_t token_len = end ? (size_t)(end - p) : strlen(p);
+		if (token_len == len && !strncmp(p, variant, len))
+			return true;
+		p = end ? end + 1 : NULL;
+	}
+	return false;
+}
+
+static bool is_feature_wanted(const registry::model &m, const char *api)
+{
+	return !strcmp(api, m.api_name);
+}
+
+//
+//'name' is the extension name without the enumeration prefix
+//
+static bool is_extension_wanted(const registry::model &m, const char *name, const char *supported)
+{
+	//We can't support many SGI extensions due to missing types
+	if (m.api == API_GLX && (strstr(name, "SGI") == name) && !strstr(name,"swap_control")) {
+		return false;
+	}
+
+	//No need to support android and it breaks due to missing types
+	if (m.api == API_EGL && strstr(name, "ANDROID")) {
+		return false;
+	}
+
+	//Check if this extension is supported by the target API
+	return is_supported(supported, m.variant_name);
+}
+
+class khronos_registry_visitor : public XMLFrozenVisitor
+{
+	registry::model &m_registry;
+	std::string m_signature;
+	bool m_commands_moved;
+
+	void model_changing()
+	{
+		if (m_registry.pipeline)
+			m_registry.pipeline->invalidate();
+	}
+
+	bool VisitEnter(const XMLFrozenNode &elem)
+	{
+		int parent = parent_tag(elem);
+		switch (elem.TagId()) {
+		case TAG_REGISTRY:
+			return elem.Parent().IsDocument();
+		case TAG_COMMANDS:
+			if (parent != TAG_REGISTRY)
+				return false;
+			model_changing();
+			return true;
+		case TAG_EXTENSIONS:
+		case TAG_TYPES:
+			return parent == TAG_REGISTRY;
+		case TAG_ENUMS: {
+			if (parent != TAG_REGISTRY)
+				return false;
+			model_changing();
+			enumeration_visitor e(m_registry, elem);
+			enumeration *enumeration = e.build();
+			if (enumeration) {
+				m_registry.enumerations.push_back(enumeration);
+			}
+			return false;
+		}
+		case TAG_FEATURE: {
+			if (parent != TAG_REGISTRY)
+				return false;
+			if (is_feature_wanted(m_registry, elem.AttributeById(ATTR_API))) {
+				interface *feature = m_registry.arena.create<interface>();
+				float version = elem.FloatAttribute("number");
+				int key = (int)roundf(version*10);
+				if (m_registry.feature_interfaces.count(key))
+					model_changing();
+				m_registry.arena.destroy(m_registry.feature_interfaces[key]);
+				m_registry.feature_interfaces[key] = feature;
+				interface_visitor i_visitor(m_registry, elem, feature);
+				elem.Accept(&i_visitor);
+				if (m_registry.pipeline)
+					m_registry.pipeline->push_feature(key, feature);
+			}
+			return false;
+		}
+		case TAG_EXTENSION: {
+			if (parent != TAG_EXTENSIONS)
+				return false;
+			const char *name = elem.AttributeById(ATTR_NAME) + strlen(m_registry.enumeration_prefix);
+			if (is_extension_wanted(m_registry, name, elem.AttributeById(ATTR_SUPPORTED))) {
+				interface *feature = m_registry.arena.create<interface>();
+				extension_interfaces_type::iterator iter = m_registry.extension_interfaces.find(name);
+				if (iter != m_registry.extension_interfaces.end()) {
+					model_changing();
+					m_registry.arena.destroy(iter->second);
+					iter->second = feature;
+				} else {
+					iter = m_registry.extension_interfaces.insert(
+							std::make_pair(m_registry.arena.copy(name), feature)).first;
+				}
+				interface_visitor i_visitor(m_registry, elem, feature);
+				elem.Accept(&i_visitor);
+				if (m_registry.pipeline)
+					m_registry.pipeline->push_extension(iter->first, feature);
+			}
+			return false;
+		}
+		case TAG_COMMAND: {
+			if (parent != TAG_COMMANDS)
+				return false;
+			command_visitor c(m_registry, elem, m_signature);
+			command * command = c.build();
+			if (command) {
+				while(command->type_decl.size() > 0 && command->type_decl[command->type_decl.size() - 1] == ' ')
+					command->type_decl.resize(command->type_decl.size() - 1);
+				//Interfaces built so far may point at the old definition or
+				//none at all
+				if (m_registry.feature_interfaces.size() || m_registry.extension_interfaces.size())
+					m_commands_moved = true;
+				m_registry.arena.destroy(m_registry.commands[command->name]);
+				m_registry.commands[command->name] = command;
+			}
+			return false;
+		}
+		case TAG_TYPE: {
+			if (parent != TAG_TYPES)
+				return false;
+			type_visitor t(m_registry);
+			elem.Accept(&t);
+			return false;
+		}
+		default:
+			return false;
+		}
+	}
+public:
+	khronos_registry_visitor(registry::model &registry) :
+		m_registry(registry), m_commands_moved(false) { }
+
+	//Whether a command was defined after a feature or extension was built
+	bool commands_moved() const { return m_commands_moved; }
+};
+
+//
+//Skips the features and extensions the visitor would ignore while the XML
+//is parsed, so no nodes are built for them
+//
+class registry_filter : public XMLParseFilter
+{
+	const registry::model &m_registry;
+
+	bool Keep(const XMLNode &parent, const XMLElement &elem)
+	{
+		switch (elem.TagId()) {
+		case TAG_FEATURE:
+			return parent.TagId() != TAG_REGISTRY ||
+				is_feature_wanted(m_registry, elem.AttributeById(ATTR_API));
+		case TAG_EXTENSION:
+			return parent.TagId() != TAG_EXTENSIONS ||
+				is_extension_wanted(m_registry, elem.AttributeById(ATTR_NAME) + strlen(m_registry.enumeration_prefix),
+						elem.AttributeById(ATTR_SUPPORTED));
+		default:
+			return true;
+		}
+	}
+public:
+	registry_filter(const registry::model &registry) : m_registry(registry) {}
+};
+
+//
+//Parse registry XML for 'm' and freeze it. The visitors walk the compact
+//frozen document, and the DOM is released before they start. The model
+//copies what it keeps, so the frozen document can be deleted once they are
+//done. Returns NULL if the XML does not parse.
+//
+static XMLFrozenDocument *parse_document(const registry::model &m, const char *data, size_t size)
+{
+	registry_filter filter(m);
+	XMLDocument doc;
+	doc.SetTagNames(tag_names, NUM_TAGS);
+	doc.SetAttributeNames(attribute_names, NUM_ATTRS);
+	doc.SetArena(true);
+	doc.SetParseFilter(&filter);
+	if (doc.Parse(data, size) != XML_NO_ERROR)
+		return NULL;
+	XMLFrozenDocument *frozen = new XMLFrozenDocument();
+	frozen->Freeze(&doc);
+	return frozen;
+}
+
+registry::registry(model *model) : m_model(model)
+{
+}
+
+registry::~registry()
+{
+	delete m_model;
+}
+
+const char *registry::xml_name(const char *api_name)
+{
+	model m;
+	return select_api(&m, api_name) ? m.xml_name : NULL;
+}
+
+//
+//Byte range of a top level element of <registry>
+//
+struct registry_section {
+	size_t begin;
+	size_t end;
+};
+
+static const char *skip_past(const char *p, const char *end, const char *str)
+{
+	size_t len = strlen(str);
+	for (; p + len <= end; p++) {
+		if (!memcmp(p, str, len))
+			return p + len;
+	}
+	return NULL;
+}
+
+static void add_section(std::vector<registry_section> *sections, const char *data, const char *begin, const char *end)
+{
+	registry_section section;
+	section.begin = begin - data;
+	section.end = end - data;
+	sections->push_back(section);
+}
+
+//
+//Find the children of the <registry> element without building a DOM. Only
+//as much XML is understood as is needed to match up tags. Returns false if
+//the structure is not recognized.
+//
+static bool find_sections(const char *data, size_t size, std::vector<registry_section> *sections)
+{
+	const char *p = data;
+	const char *end = data + size;
+	const char *section_begin = NULL;
+	int depth = 0;
+	while ((p = (const char *)memchr(p, '<', end - p))) {
+		const char *tag = p;
+		if (end - p >= 4 && !memcmp(p, "<!--", 4)) {
+			p = skip_past(p + 4, end, "-->");
+		} else if (end - p >= 9 && !memcmp(p, "<![CDATA[", 9)) {
+			p = skip_past(p + 9, end, "]]>");
+		} else if (end - p >= 2 && p[1] == '?') {
+			p = skip_past(p + 2, end, "?>");
+		} else if (end - p >= 2 && p[1] == '!') {
+			p = skip_past(p + 2, end, ">");
+		} else {
+			bool closing = end - p >= 2 && p[1] == '/';
+			char quote = 0;
+			for (p++; p < end; p++) {
+				if (quote) {
+					if (*p == quote)
+						quote = 0;
+				} else if (*p == '"' || *p == '\'') {
+					quote = *p;
+				} else if (*p == '>') {
+					break;
+				}
+			}
+			if (p == end)
+				return false;
+			bool empty = !closing && p[-1] == '/';
+			p++;
+			if (closing) {
+				if (--depth < 0)
+					return false;
+				if (depth == 1)
+					add_section(sections, data, section_begin, p);
+			} else if (depth == 0) {
+				if (end - tag < 10 || memcmp(tag + 1, "registry", 8) || isalnum((unsigned char)tag[9]))
+					return false;
+				if (!empty)
+					depth++;
+			} else if (!empty) {
+				if (depth == 1)
+					section_begin = tag;
+				depth++;
+			} else if (depth == 1) {
+				add_section(sections, data, tag, p);
+			}
+		}
+		if (!p)
+			return false;
+	}
+	return depth == 0;
+}
+
+//
+//Parses a run of consecutive sections into a model of its own
+//
+class section_parser : public thread {
+	registry::model *m_model;
+	std::string m_xml;
+	bool m_ok;
+
+	void run()
+	{
+		XMLFrozenDocument *doc = parse_document(*m_model, m_xml.data(), m_xml.size());
+		std::string().swap(m_xml);
+		m_ok = doc != NULL;
+		if (m_ok) {
+			khronos_registry_visitor registry_visitor(*m_model);
+			doc->Document().Accept(&registry_visitor);
+			delete doc;
+		}
+	}
+public:
+	section_parser(registry::model *model, const char *data, size_t size) :
+		m_model(model), m_ok(false)
+	{
+		m_xml.reserve(size + 32);
+		m_xml += "<registry>";
+		m_xml.append(data, size);
+		m_xml += "</registry>";
+	}
+
+	bool ok() const { return m_ok; }
+};
+
+//
+//Point the commands of an interface at their final definitions, which may
+//have followed the interface or replaced an earlier definition. Without
+//'lookup' only those missing when the interface was built are looked up.
+//Returns false and sets 'error' if one is never defined.
+//
+static bool resolve_interface_commands(registry::model *m, commands_type &commands, bool lookup,
+		const std::string &name, std::string *error)
+{
+	FOREACH (iter, commands, commands_type) {
+		if (iter->second && !lookup)
+			continue;
+		commands_type::const_iterator command = m->commands.find(iter->first);
+		if (command == m->commands.end() || !command->second) {
+			if (error)
+				*error = std::string("Command '") + m->command_prefix + iter->first + "' used by " + name + " is not defined";
+			return false;
+		}
+		iter->second = command->second;
+	}
+	return true;
+}
+
+//
+//Every command of an interface is defined once this succeeds and the model
+//only holds defined commands, so the emitter and the table dump can rely
+//on it. Entries left by interfaces that were later replaced are dropped.
+//
+static bool resolve_commands(registry::model *m, bool lookup, std::string *error)
+{
+	FOREACH (iter, m->feature_interfaces, feature_interfaces_type) {
+		char name[64];
+		snprintf(name, sizeof(name), "%sVERSION_%d_%d", m->enumeration_prefix, iter->first / 10, iter->first % 10);
+		if (!resolve_interface_commands(m, iter->second->commands, lookup, name, error) ||
+		    !resolve_interface_commands(m, iter->second->removed_commands, lookup, name, error))
+			return false;
+	}
+	FOREACH (iter, m->extension_interfaces, extension_interfaces_type) {
+		std::string name = std::string(m->enumeration_prefix) + iter->first;
+		if (!resolve_interface_commands(m, iter->second->commands, lookup, name, error) ||
+		    !resolve_interface_commands(m, iter->second->removed_commands, lookup, name, error))
+			return false;
+	}
+	commands_type::iterator iter = m->commands.begin();
+	while (iter != m->commands.end()) {
+		if (iter->second)
+			iter++;
+		else
+			m->commands.erase(iter++);
+	}
+	return true;
+}
+
+//
+//Move everything in 'src' into 'dst' as if its sections had followed those
+//of 'dst' in one document. Interfaces are left pointing at the commands of
+//'src' until resolve_commands() is run on the merged model.
+//
+static void merge_model(registry::model *dst, registry::model *src)
+{
+	dst->arena.adopt(src->arena);
+
+	dst->enumerations.insert(dst->enumerations.end(), src->enumerations.begin(), src->enumerations.end());
+	src->enumerations.clear();
+
+	FOREACH (iter, src->enum_map, enum_map_type)
+		dst->enum_map[iter->first] = iter->second;
+
+	FOREACH (iter, src->enum_str_map, enum_str_map_type)
+		dst->enum_str_map[iter->first] = iter->second;
+
+	//Entries without a command are references from interfaces that were
+	//not defined in the sections of 'src'
+	FOREACH (iter, src->commands, commands_type) {
+		if (!iter->second)
+			continue;
+		commands_type::iterator old = dst->commands.find(iter->first);
+		if (old != dst->commands.end())
+			dst->arena.destroy(old->second);
+		dst->commands[iter->first] = iter->second;
+	}
+	src->commands.clear();
+
+	FOREACH (iter, src->types, types_type) {
+		if (!dst->common_gl_typedefs.count(iter->name)) {
+			dst->common_gl_typedefs.insert(iter->name);
+			dst->types.push_back(*iter);
+		}
+	}
+
+	FOREACH (iter, src->feature_interfaces, feature_interfaces_type) {
+		dst->arena.destroy(dst->feature_interfaces[iter->first]);
+		dst->feature_interfaces[iter->first] = iter->second;
+	}
+	src->feature_interfaces.clear();
+
+	FOREACH (iter, src->extension_interfaces, extension_interfaces_type) {
+		dst->arena.destroy(dst->extension_interfaces[iter->first]);
+		dst->extension_interfaces[iter->first] = iter->second;
+	}
+	src->extension_interfaces.clear();
+}
+
+//
+//Split the sections into up to 'threads' runs of about equal size, parse and
+//model each run on its own thread and merge the results in document order.
+//
+static bool load_sections(registry::model *m, const char *data, const std::vector<registry_section> &sections,
+		unsigned int threads, double start)
+{
+	size_t total = 0;
+	for (unsigned int i = 0; i < sections.size(); i++)
+		total += sections[i].end - sections[i].begin;
+
+	std::vector<registry::model *> models;
+	std::vector<section_parser *> parsers;
+	unsigned int first = 0;
+	size_t done = 0;
+	while (first < sections.size()) {
+		size_t target = total * (parsers.size() + 1) / threads;
+		unsigned int last = first;
+		done += sections[last].end - sections[last].begin;
+		while (last + 1 < sections.size() && done < target) {
+			last++;
+			done += sections[last].end - sections[last].begin;
+		}
+		registry::model *part = new registry::model();
+		select_api(part, m->api_name);
+		models.push_back(part);
+		parsers.push_back(new section_parser(part, data + sections[first].begin,
+					sections[last].end - sections[first].begin));
+		first = last + 1;
+	}
+
+	for (unsigned int i = 0; i < parsers.size(); i++)
+		parsers[i]->start();
+	bool ok = true;
+	for (unsigned int i = 0; i < parsers.size(); i++) {
+		parsers[i]->join();
+		ok = ok && parsers[i]->ok();
+		delete parsers[i];
+	}
+	double parsed = time_ms();
+	m->parse_time = parsed - start;
+
+	for (unsigned int i = 0; i < models.size(); i++) {
+		if (ok)
+			merge_model(m, models[i]);
+		delete models[i];
+	}
+	if (!ok)
+		return false;
+	m->build_time = time_ms() - parsed;
+	return true;
+}
+
+static registry::model *load_model(const char *api_name, const char *data, size_t size, double start,
+		unsigned int threads, const options *pipeline, std::string *error)
+{
+	registry::model *m = new registry::model();
+	if (!select_api(m, api_name)) {
+		if (error)
+			*error = std::string("Unrecognized API '") + api_name + "'";
+		delete m;
+		return NULL;
+	}
+	m->xml_hash = fnv1a_64(data, size);
+
+	if (!threads)
+		threads = processor_count();
+	std::vector<registry_section> sections;
+	if (threads > 1 && find_sections(data, size, &sections) && sections.size() > 1) {
+		if (!load_sections(m, data, sections, threads, start)) {
+			if (error)
+				*error = "Error parsing khronos registry";
+			delete m;
+			return NULL;
+		}
+		double resolving = time_ms();
+		if (!resolve_commands(m, true, error)) {
+			delete m;
+			return NULL;
+		}
+		m->build_time += time_ms() - resolving;
+		return m;
+	}
+
+	XMLFrozenDocument *doc = parse_document(*m, data, size);
+	if (!doc) {
+		if (error)
+			*error = "Error parsing khronos registry";
+		delete m;
+		return NULL;
+	}
+	double parsed = time_ms();
+	m->parse_time = parsed - start;
+
+	if (pipeline && thread::supported())
+		m->pipeline = new declaration_pipeline(*m, *pipeline);
+	khronos_registry_visitor registry_visitor(*m);
+	doc->Document().Accept(&registry_visitor);
+	delete doc;
+	if (m->pipeline) {
+		m->pipeline->finish();
+		delete m->pipeline;
+		m->pipeline = NULL;
+	}
+	if (!resolve_commands(m, registry_visitor.commands_moved(), error)) {
+		delete m;
+		return NULL;
+	}
+	m->build_time = time_ms() - parsed;
+	return m;
+}
+
+registry *registry::load_buffer(const char *api_name, const char *data, size_t size, std::string *error,
+		unsigned int threads, const options *pipeline)
+{
+	model *m = load_model(api_name, data, size, time_ms(), threads, pipeline, error);
+	return m ? new registry(m) : NULL;
+}
+
+registry *registry::load_file(const char *api_name, const char *filename, std::string *error,
+		unsigned int threads, const options *pipeline)
+{
+	double start = time_ms();
+	std::string xml;
+	std::string read_error;
+	if (!read_registry(filename, &xml, &read_error)) {
+		if (error)
+			*error = read_error;
+		return NULL;
+	}
+	model *m = load_model(api_name, xml.data(), xml.size(), start, threads, pipeline, error);
+	if (!m) {
+		if (error)
+			*error = std::string("Error loading khronos registry file ") + filename + ": " + *error;
+		return NULL;
+	}
+	return new registry(m);
+}
+
+const char *registry::api_name() const
+{
+	return m_model->api_name;
+}
+
+const char *registry::variant_name() const
+{
+	return m_model->variant_name;
+}
+
+const char *registry::print_name() const
+{
+	return m_model->api_print_name;
+}
+
+int registry::min_version() const
+{
+	return m_model->min_version;
+}
+
+uint64_t registry::hash() const
+{
+	return m_model->xml_hash;
+}
+
+double registry::parse_time() const
+{
+	return m_model->parse_time;
+}
+
+double registry::build_time() const
+{
+	return m_model->build_time;
+}
+
+static void load_table_interface(registry::model *m, interface *iface, const builtin_registry &tables, const builtin_interface &builtin)
+{
+	for (unsigned int i = 0; i < builtin.num_items; i++) {
+		const builtin_interface_item &item = tables.items[builtin.first_item + i];
+		switch (item.list) {
+		case BUILTIN_ENUM:
+			iface->enums.insert(item.name);
+			break;
+		case BUILTIN_COMMAND:
+			iface->commands[item.name] = m->commands[item.name];
+			break;
+		case BUILTIN_REMOVED_ENUM:
+			iface->removed_enums.insert(item.name);
+			break;
+		case BUILTIN_REMOVED_COMMAND:
+			iface->removed_commands[item.name] = m->commands[item.name];
+			break;
+		}
+	}
+}
+
+registry *registry::load_tables(const builtin_registry &tables)
+{
+	double start = time_ms();
+	model *m = new model();
+	if (!select_api(m, tables.api_name)) {
+		delete m;
+		return NULL;
+	}
+	m->xml_hash = ((uint64_t)tables.xml_hash_hi << 32) | tables.xml_hash_lo;
+
+	for (unsigned int i = 0; i < tables.num_commands; i++) {
+		const builtin_command &builtin = tables.commands[i];
+		command *command = m->arena.create<struct command>();
+		command->name = builtin.name;
+		command->type = builtin.type;
+		command->type_decl = builtin.type_decl;
+		command->signature = builtin.signature;
+		command->signature_length = strlen(builtin.signature);
+		for (unsigned int j = 0; j < builtin.num_params; j++) {
+			const builtin_param &builtin_param = tables.params[builtin.first_param + j];
+			command::param param;
+			param.type = builtin_param.type;
+			param.name = builtin_param.name;
+			param.decl_offset = builtin_param.decl_offset;
+			param.decl_length = builtin_param.decl_length;
+			command->params.push_back(param);
+		}
+		m->commands[command->name] = command;
+	}
+
+	for (unsigned int i = 0; i < tables.num_enumerations; i++) {
+		const builtin_enumeration &builtin = tables.enumerations[i];
+		enumeration *enumeration = m->arena.create<struct enumeration>();
+		enumeration->name = builtin.name;
+		for (unsigned int j = 0; j < builtin.num_enums; j++) {
+			const builtin_enum &builtin_enum = tables.enums[builtin.first_enum + j];
+			enum_value val = { builtin_enum.value, builtin_enum.suffix };
+			enumeration->enum_map[builtin_enum.name] = val;
+			m->enum_map[builtin_enum.name] = val;
+		}
+		m->enumerations.push_back(enumeration);
+	}
+
+	for (unsigned int i = 0; i < tables.num_enum_strs; i++)
+		m->enum_str_map[tables.enum_strs[i].name] = tables.enum_strs[i].value;
+
+	for (unsigned int i = 0; i < tables.num_types; i++) {
+		type type;
+		type.name = tables.types[i].name;
+		type.requires = tables.types[i].requires;
+		type.decl = tables.types[i].decl;
+		m->types.push_back(type);
+	}
+
+	for (unsigned int i = 0; i < tables.num_features; i++) {
+		interface *feature = m->arena.create<interface>();
+		m->feature_interfaces[tables.features[i].version] = feature;
+		load_table_interface(m, feature, tables, tables.features[i]);
+	}
+
+	for (unsigned int i = 0; i < tables.num_extensions; i++) {
+		interface *extension = m->arena.create<interface>();
+		m->extension_interfaces[tables.extensions[i].name] = extension;
+		load_table_interface(m, extension, tables, tables.extensions[i]);
+	}
+	m->build_time = time_ms() - start;
+	return new registry(m);
+}
+
+static void print_c_string(writer &out, const char *str)
+{
+	if (!str) {
+		out.print("NULL");
+		return;
+	}
+	std::string escaped;
+	escaped += '"';
+	for (const char *p = str; *p; p++) {
+		switch (*p) {
+		case '\\':
+		case '"':
+		case '?':
+			escaped += '\\';
+			escaped += *p;
+			break;
+		case '\n':
+			escaped += "\\n";
+			break;
+		case '\t':
+			escaped += "\\t";
+			break;
+		default:
+			if ((unsigned char)*p < ' ') {
+				char buf[8];
+				snprintf(buf, sizeof(buf), "\\%03o", (unsigned char)*p);
+				escaped += buf;
+			} else {
+				escaped += *p;
+			}
+		}
+	}
+	escaped += '"';
+	out.print("%s", escaped.c_str());
+}
+
+static void dump_interface_items(writer &out, const interface &iface)
+{
+	FOREACH_CONST (val, iface.enums, enums_type) {
+		out.print("\t{ BUILTIN_ENUM, ");
+		print_c_string(out, *val);
+		out.print(" },\n");
+	}
+	FOREACH_CONST (iter, iface.commands, commands_type) {
+		out.print("\t{ BUILTIN_COMMAND, ");
+		print_c_string(out, iter->first);
+		out.print(" },\n");
+	}
+	FOREACH_CONST (val, iface.removed_enums, enums_type) {
+		out.print("\t{ BUILTIN_REMOVED_ENUM, ");
+		print_c_string(out, *val);
+		out.print(" },\n");
+	}
+	FOREACH_CONST (iter, iface.removed_commands, commands_type) {
+		out.print("\t{ BUILTIN_REMOVED_COMMAND, ");
+		print_c_string(out, iter->first);
+		out.print(" },\n");
+	}
+}
+
+static unsigned int interface_num_items(const interface &iface)
+{
+	return iface.enums.size() + iface.commands.size() + iface.removed_enums.size() + iface.removed_commands.size();
+}
+
+//
+//Every table gets a trailing sentinel entry so that none of them is empty
+//
+void dump_registry_tables(const registry &reg, const char *sym, output_sink &sink)
+{
+	const registry::model &m = reg.get_model();
+	writer out(sink);
+	unsigned int index;
+
+	out.print("static const builtin_param %s_params[] = {\n", sym);
+	FOREACH_CONST (iter, m.commands, commands_type) {
+		const command *command = iter->second;
+		for (unsigned int i = 0; i < command->params.size(); i++) {
+			out.print("\t{ ");
+			print_c_string(out, command->params[i].type);
+			out.print(", ");
+			print_c_string(out, command->params[i].name);
+			out.print(", %u, %u },\n", command->params[i].decl_offset, command->params[i].decl_length);
+		}
+	}
+	out.print("\t{ NULL, NULL, 0, 0 }\n};\n\n");
+
+	index = 0;
+	out.print("static const builtin_command %s_commands[] = {\n", sym);
+	FOREACH_CONST (iter, m.commands, commands_type) {
+		const command *command = iter->second;
+		out.print("\t{ ");
+		print_c_string(out, command->name);
+		out.print(", ");
+		print_c_string(out, command->type);
+		out.print(", ");
+		print_c_string(out, command->type_decl.c_str());
+		out.print(", ");
+		print_c_string(out, command->signature);
+		out.print(", %u, %u },\n", index, (unsigned int)command->params.size());
+		index += command->params.size();
+	}
+	out.print("\t{ NULL, NULL, NULL, NULL, 0, 0 }\n};\n\n");
+
+	out.print("static const builtin_enum %s_enums[] = {\n", sym);
+	FOREACH_CONST (iter, m.enumerations, enumerations_type) {
+		const enumeration *enumeration = *iter;
+		FOREACH_CONST (val, enumeration->enum_map, enum_map_type) {
+			out.print("\t{ ");
+			print_c_string(out, val->first);
+			out.write(", 0x").write_hex(val->second.value);
+			if (val->second.value >> 32)
+				out.write("ull");
+			out.print(", %d },\n", val->second.suffix);
+		}
+	}
+	out.print("\t{ NULL, 0, 0 }\n};\n\n");
+
+	index = 0;
+	out.print("static const builtin_enumeration %s_enumerations[] = {\n", sym);
+	FOREACH_CONST (iter, m.enumerations, enumerations_type) {
+		const enumeration *enumeration = *iter;
+		out.print("\t{ ");
+		print_c_string(out, enumeration->name);
+		out.print(", %u, %u },\n", index, (unsigned int)enumeration->enum_map.size());
+		index += enumeration->enum_map.size();
+	}
+	out.print("\t{ NULL, 0, 0 }\n};\n\n");
+
+	out.print("static const builtin_enum_str %s_enum_strs[] = {\n", sym);
+	FOREACH_CONST (iter, m.enum_str_map, enum_str_map_type) {
+		out.print("\t{ ");
+		print_c_string(out, iter->first);
+		out.print(", ");
+		print_c_string(out, iter->second);
+		out.print(" },\n");
+	}
+	out.print("\t{ NULL, NULL }\n};\n\n");
+
+	out.print("static const builtin_type %s_types[] = {\n", sym);
+	FOREACH_CONST (val, m.types, types_type) {
+		out.print("\t{ ");
+		print_c_string(out, val->name);
+		out.print(", ");
+		print_c_string(out, val->requires);
+		out.print(", ");
+		print_c_string(out, val->decl.c_str());
+		out.print(" },\n");
+	}
+	out.print("\t{ NULL, NULL, NULL }\n};\n\n");
+
+	out.print("static const builtin_interface_item %s_items[] = {\n", sym);
+	FOREACH_CONST (iter, m.feature_interfaces, feature_interfaces_type)
+		dump_interface_items(out, *iter->second);
+	FOREACH_CONST (iter, m.extension_interfaces, extension_interfaces_type)
+		dump_interface_items(out, *iter->second);
+	out.print("\t{ 0, NULL }\n};\n\n");
+
+	index = 0;
+	out.print("static const builtin_interface %s_features[] = {\n", sym);
+	FOREACH_CONST (iter, m.feature_interfaces, feature_interfaces_type) {
+		out.print("\t{ %d, NULL, %u, %u },\n", iter->first, index, interface_num_items(*iter->second));
+		index += interface_num_items(*iter->second);
+	}
+	out.print("\t{ 0, NULL, 0, 0 }\n};\n\n");
+
+	out.print("static const builtin_interface %s_extensions[] = {\n", sym);
+	FOREACH_CONST (iter, m.extension_interfaces, extension_interfaces_type) {
+		out.print("\t{ 0, ");
+		print_c_string(out, iter->first);
+		out.print(", %u, %u },\n", index, interface_num_items(*iter->second));
+		index += interface_num_items(*iter->second);
+	}
+	out.print("\t{ 0, NULL, 0, 0 }\n};\n\n");
+
+	out.print("static const builtin_registry %s_registry = {\n", sym);
+	out.print("\t\"%s\", \"%s\", 0x%08xu, 0x%08xu,\n", m.api_name, m.xml_name,
+			(unsigned int)(m.xml_hash >> 32), (unsigned int)m.xml_hash);
+	out.print("\t%s_commands, %u, %s_params,\n", sym, (unsigned int)m.commands.size(), sym);
+	out.print("\t%s_enumerations, %u, %s_enums, %s_enum_strs, %u,\n", sym,
+			(unsigned int)m.enumerations.size(), sym, sym, (unsigned int)m.enum_str_map.size());
+	out.print("\t%s_types, %u,\n", sym, (unsigned int)m.types.size());
+	out.print("\t%s_features, %u, %s_extensions, %u, %s_items\n", sym,
+			(unsigned int)m.feature_interfaces.size(), sym, (unsigned int)m.extension_interfaces.size(), sym);
+	out.print("};\n\n");
+}
+
+}
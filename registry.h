@@ -0,0 +1,242 @@
+#ifndef GLBINDIFY_REGISTRY_H
+#define GLBINDIFY_REGISTRY_H
+
+//
+//Internal registry model shared by the parser and the emitter
+//
+
+#include <string.h>
+
+#include <new>
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+
+#include "glbindify.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#else
+#define PACKAGE_VERSION "<unknown>"
+#define PACKAGE_STRING "<unknown>"
+#endif
+
+namespace glbindify {
+
+#define FOREACH(var, cont, type) \
+	for (type::iterator var = cont.begin(); var != cont.end(); var++)
+
+#define FOREACH_CONST(var, cont, type) \
+	for (type::const_ ## iterator var = cont.begin(); var != cont.end(); var++)
+
+enum API {
+	API_GL,
+	API_GLES2,
+	API_EGL,
+	API_GLX,
+	API_WGL
+};
+
+class writer;
+class declaration_pipeline;
+
+struct cstring_compare {
+	bool operator()(const char *a, const char *b) const {
+		return strcmp(a, b) < 0;
+	}
+};
+
+//
+//Type suffix an enum value is written with in C
+//
+enum enum_suffix {
+	ENUM_SUFFIX_NONE,
+	ENUM_SUFFIX_U,
+	ENUM_SUFFIX_ULL
+};
+
+//
+//Bump allocator the model is built in. Names are copied into it, so the model
+//does not depend on the XML it was built from, and commands, enumerations and
+//interfaces are placed in it. Memory is only returned when the arena is
+//destroyed; objects must be destroyed by their owner first.
+//
+class model_arena {
+	std::vector<char *> m_chunks;
+	char *m_next;
+	size_t m_left;
+
+	model_arena(const model_arena &);
+	model_arena &operator=(const model_arena &);
+public:
+	model_arena() : m_next(NULL), m_left(0) {}
+	~model_arena();
+
+	void *alloc(size_t size);
+	const char *copy(const char *str, size_t length);
+	const char *copy(const char *str) { return copy(str, strlen(str)); }
+
+	template <class T> T *create() { return new (alloc(sizeof(T))) T(); }
+	template <class T> void destroy(T *obj) { if (obj) obj->~T(); }
+
+	//Take over the memory of 'other', which is left empty
+	void adopt(model_arena &other);
+};
+
+struct enum_value {
+	uint64_t value;
+	int suffix;
+};
+
+struct enumeration {
+	const char *name;
+	std::map<const char *, enum_value, cstring_compare> enum_map;
+	enumeration() : name(NULL) {}
+};
+
+struct command {
+	const char *name;
+	const char *type;
+	std::string type_decl;
+	struct param {
+		const char *type;
+		const char *name;
+		//Declaration of the parameter within 'signature'
+		unsigned int decl_offset;
+		unsigned int decl_length;
+		param() : type(NULL), name(NULL), decl_offset(0), decl_length(0) {}
+	};
+	std::vector<param> params;
+
+	//Declarations of all parameters separated by ", ", as written between
+	//the parentheses of a function pointer. Built once when the command is
+	//loaded, the emitter copies it as is.
+	const char *signature;
+	size_t signature_length;
+
+	//Defined by the emitter
+	void print_declare(writer &out, const char *command_prefix) const;
+	void print_initialize(writer &out, const char *command_prefix) const;
+	void print_load(writer &out, const char *command_prefix) const;
+
+	command() : name(NULL), type(NULL), signature(""), signature_length(0) {}
+};
+
+typedef std::map<const char *, command *, cstring_compare> commands_type;
+typedef std::set<const char *, cstring_compare> enums_type;
+
+struct interface {
+	enums_type enums;
+	commands_type commands;
+	enums_type removed_enums;
+	commands_type removed_commands;
+};
+
+typedef std::map<const char *, enum_value, cstring_compare> enum_map_type;
+typedef std::map<const char *, const char *, cstring_compare> enum_str_map_type;
+typedef std::vector<enumeration *> enumerations_type;
+//
+//A type declared by the registry. 'requires' names another type the
+//declaration depends on, if any.
+//
+struct type {
+	const char *name;
+	const char *requires;
+	std::string decl;
+	type() : name(NULL), requires(NULL) {}
+};
+
+typedef std::vector<type> types_type;
+typedef std::map<int, interface *> feature_interfaces_type;
+typedef std::map<const char *, interface *, cstring_compare> extension_interfaces_type;
+typedef std::map<const char *, std::string, cstring_compare> extension_text_type;
+
+//
+//Parts of the bindings formatted while the registry was being loaded. They
+//are only used by bindify() for the prefix they were formatted with.
+//
+struct prepared_declarations {
+	bool valid;
+	std::string prefix;
+	enum_style enums;
+	std::map<int, std::string> features;
+	extension_text_type extensions;
+	extension_text_type extension_checks;
+	prepared_declarations() : valid(false), enums(ENUM_STYLE_MACRO) {}
+};
+
+struct registry::model {
+	//Api description
+	enum API api;
+	const char *api_name;
+	const char *variant_name;
+	const char *command_prefix;
+	const char *enumeration_prefix;
+	const char *api_print_name;
+	const char *xml_name;
+	int min_version;
+
+	std::set<const char *, cstring_compare> common_gl_typedefs;
+
+	//List of all enums and commands
+	enum_map_type enum_map;
+	enum_str_map_type enum_str_map;
+	enumerations_type enumerations;
+	commands_type commands;
+	types_type types;
+	feature_interfaces_type feature_interfaces;
+	extension_interfaces_type extension_interfaces;
+
+	uint64_t xml_hash;
+	double parse_time;
+	double build_time;
+
+	prepared_declarations prepared;
+
+	//Set while the registry is being loaded with a pipeline
+	declaration_pipeline *pipeline;
+
+	//Strings in the model point into the arena, or into static tables for
+	//a model loaded from them
+	model_arena arena;
+
+	bool is_command_in_namespace(const char **name) const;
+	bool is_enum_in_namespace(const char **name) const;
+
+	model();
+	~model();
+};
+
+//
+//Defined by the emitter. Format what bindify() writes for a single feature
+//or extension, none of which depends on other features or extensions.
+//
+void format_feature_declaration(const registry::model &m, const char *prefix, enum_style enums,
+		int version, const interface &iface, std::string *out);
+void format_extension_declaration(const registry::model &m, const char *prefix, enum_style enums,
+		const char *name, const interface &iface, std::string *out);
+void format_extension_check(const registry::model &m, const char *prefix, const char *name,
+		const interface &iface, std::string *out);
+
+//
+//Wall clock in milliseconds, only meaningful as a difference between two calls
+//
+double time_ms();
+
+//
+//64-bit FNV-1a
+//
+uint64_t fnv1a_64(const void *data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL);
+
+bool read_file(const char *filename, std::string *contents);
+
+//
+//Read a registry file, "-" for stdin. gzip compressed files are inflated if
+//built with zlib. Sets 'error' on failure.
+//
+bool read_registry(const char *filename, std::string *contents, std::string *error);
+
+}
+
+#endif
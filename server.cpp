@@ -0,0 +1,487 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <map>
+
+#include "builtin_registry.h"
+#include "registry.h"
+#include "server.h"
+
+#if !defined(_WIN32)
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+using namespace glbindify;
+
+registry *load_registry(const char *api_name, const char *srcdir, const char *default_srcdir,
+		unsigned int threads, const options *pipeline, std::string *registry_file,
+		std::string *error)
+{
+#ifdef GLBINDIFY_BUILTIN_REGISTRY
+	if (!srcdir) {
+		for (unsigned int i = 0; i < g_num_builtin_registries; i++) {
+			if (!strcmp(g_builtin_registries[i]->api_name, api_name)) {
+				registry_file->clear();
+				return registry::load_tables(*g_builtin_registries[i]);
+			}
+		}
+	}
+#endif
+	const char *xml_name = registry::xml_name(api_name);
+	if (!xml_name) {
+		*error = std::string("Unrecognized API '") + api_name + "'";
+		return NULL;
+	}
+	*registry_file = std::string(srcdir ? srcdir : default_srcdir) + "/" + xml_name;
+
+	//Vendored registries may be stored compressed
+	FILE *file = fopen(registry_file->c_str(), "rb");
+	if (file) {
+		fclose(file);
+	} else {
+		std::string compressed = *registry_file + ".gz";
+		file = fopen(compressed.c_str(), "rb");
+		if (file) {
+			fclose(file);
+			registry_file->swap(compressed);
+		}
+	}
+	return registry::load_file(api_name, registry_file->c_str(), error, threads, pipeline);
+}
+
+class split_header_list : public header_set {
+	bindings &m_result;
+public:
+	split_header_list(bindings &result) : m_result(result) {}
+
+	virtual void add(const std::string &name, const std::string &contents)
+	{
+		m_result.split_headers.push_back(std::make_pair(name, contents));
+	}
+};
+
+void generate_bindings(const registry &reg, const char *prefix, enum_style enums,
+		bool used_types, bool split, unsigned int threads, bindings *result)
+{
+	double start = time_ms();
+	options opts;
+	std::string header_name = std::string(reg.variant_name()) + ".h";
+	opts.prefix = prefix;
+	opts.enums = enums;
+	opts.used_types = used_types;
+	opts.header_name = header_name.c_str();
+	opts.threads = threads;
+
+	string_sink header, source;
+	split_header_list headers(*result);
+	if (split)
+		bindify_split(reg, opts, header, source, headers);
+	else
+		bindify(reg, opts, header, source);
+
+	result->variant_name = reg.variant_name();
+	result->print_name = reg.print_name();
+	result->registry_hash = reg.hash();
+	result->header.swap(header.str);
+	result->source.swap(source.str);
+	result->parse_time = reg.parse_time();
+	result->build_time = reg.build_time();
+	result->emit_time = time_ms() - start;
+}
+
+#if !defined(_WIN32)
+
+//
+//Requests and replies are sequences of netstrings ("<length>:<bytes>,")
+//over a stream socket, one request per connection
+//
+#define PROTOCOL_NAME "glbindify-3"
+
+//Upper bound on a single field, well above the size of any bindings
+#define MAX_FIELD_SIZE (256 * 1024 * 1024)
+
+//Seconds a client may stall reading or writing before it is dropped, so
+//one stuck client can't hold up the others
+#define CLIENT_TIMEOUT 10
+
+static bool write_all(int fd, const char *data, size_t size)
+{
+	while (size) {
+		ssize_t count = write(fd, data, size);
+		if (count < 0 && errno == EINTR)
+			continue;
+		if (count <= 0)
+			return false;
+		data += count;
+		size -= count;
+	}
+	return true;
+}
+
+static bool read_all(int fd, char *data, size_t size)
+{
+	while (size) {
+		ssize_t count = read(fd, data, size);
+		if (count < 0 && errno == EINTR)
+			continue;
+		if (count <= 0)
+			return false;
+		data += count;
+		size -= count;
+	}
+	return true;
+}
+
+static bool send_field(int fd, const std::string &field)
+{
+	char len[32];
+	snprintf(len, sizeof(len), "%u:", (unsigned int)field.size());
+	return write_all(fd, len, strlen(len)) &&
+		write_all(fd, field.data(), field.size()) &&
+		write_all(fd, ",", 1);
+}
+
+static bool send_field(int fd, double value)
+{
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%.6f", value);
+	return send_field(fd, std::string(buf));
+}
+
+static bool recv_field(int fd, std::string *field)
+{
+	size_t size = 0;
+	char c;
+	while (1) {
+		if (!read_all(fd, &c, 1))
+			return false;
+		if (c == ':')
+			break;
+		if (c < '0' || c > '9' || size > MAX_FIELD_SIZE / 10)
+			return false;
+		size = size * 10 + (c - '0');
+	}
+	if (size > MAX_FIELD_SIZE)
+		return false;
+	field->resize(size);
+	if (size && !read_all(fd, &(*field)[0], size))
+		return false;
+	return read_all(fd, &c, 1) && c == ',';
+}
+
+static bool send_field(int fd, int value)
+{
+	char buf[32];
+	snprintf(buf, sizeof(buf), "%d", value);
+	return send_field(fd, std::string(buf));
+}
+
+static bool recv_field(int fd, double *value)
+{
+	std::string field;
+	if (!recv_field(fd, &field))
+		return false;
+	*value = strtod(field.c_str(), NULL);
+	return true;
+}
+
+static bool make_address(const char *socket_name, struct sockaddr_un *addr)
+{
+	if (strlen(socket_name) >= sizeof(addr->sun_path)) {
+		fprintf(stderr, "Socket path '%s' is too long\n", socket_name);
+		return false;
+	}
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	strcpy(addr->sun_path, socket_name);
+	return true;
+}
+
+//
+//A loaded registry along with what is needed to notice that its file
+//changed. Registries built from compiled in tables never change.
+//
+struct cached_registry {
+	registry *reg;
+	std::string registry_file;
+	time_t mtime;
+	off_t size;
+};
+
+typedef std::map<std::string, cached_registry> registry_cache_type;
+
+static bool file_changed(const cached_registry &cached, struct stat *st)
+{
+	if (cached.registry_file.empty())
+		return false;
+	if (stat(cached.registry_file.c_str(), st))
+		return true;
+	return st->st_mtime != cached.mtime || st->st_size != cached.size;
+}
+
+static const registry *lookup_registry(registry_cache_type &cache, const bindings_request &request,
+		const char *server_srcdir, const char *default_srcdir, unsigned int threads,
+		std::string *registry_file, bool *loaded, std::string *error)
+{
+	const char *srcdir = request.srcdir.empty() ? server_srcdir : request.srcdir.c_str();
+	std::string key = request.api_name + '\n' + request.srcdir;
+	registry_cache_type::iterator iter = cache.find(key);
+	struct stat st;
+	if (iter != cache.end()) {
+		if (!file_changed(iter->second, &st)) {
+			*registry_file = iter->second.registry_file;
+			*loaded = false;
+			return iter->second.reg;
+		}
+		printf("%s changed, reloading\n", iter->second.registry_file.c_str());
+		delete iter->second.reg;
+		cache.erase(iter);
+	}
+
+	//The files load_registry() may read are checked before it reads one
+	//so a change while it is being read is picked up by the next request.
+	//The one it actually read, possibly the compressed copy, is recorded.
+	cached_registry cached;
+	std::string file, compressed;
+	struct stat file_st, compressed_st;
+	bool have_file = false, have_compressed = false;
+	const char *xml_name = registry::xml_name(request.api_name.c_str());
+	if (xml_name) {
+		file = std::string(srcdir ? srcdir : default_srcdir) + "/" + xml_name;
+		compressed = file + ".gz";
+		have_file = !stat(file.c_str(), &file_st);
+		have_compressed = !stat(compressed.c_str(), &compressed_st);
+	}
+	cached.reg = load_registry(request.api_name.c_str(), srcdir, default_srcdir, threads, NULL, &cached.registry_file, error);
+	if (!cached.reg)
+		return NULL;
+	if (have_file && cached.registry_file == file)
+		st = file_st;
+	else if (have_compressed && cached.registry_file == compressed)
+		st = compressed_st;
+	else if (cached.registry_file.empty() || stat(cached.registry_file.c_str(), &st))
+		st.st_mtime = st.st_size = 0;
+	cached.mtime = st.st_mtime;
+	cached.size = st.st_size;
+	cache[key] = cached;
+	*registry_file = cached.registry_file;
+	*loaded = true;
+	return cached.reg;
+}
+
+static void handle_request(int fd, registry_cache_type &cache, const char *srcdir, const char *default_srcdir,
+		unsigned int threads)
+{
+	std::string protocol, enums, used_types;
+	bindings_request request;
+	if (!recv_field(fd, &protocol) || protocol != PROTOCOL_NAME ||
+	    !recv_field(fd, &request.api_name) ||
+	    !recv_field(fd, &request.prefix) ||
+	    !recv_field(fd, &enums) ||
+	    !recv_field(fd, &used_types) ||
+	    !recv_field(fd, &request.srcdir) ||
+	    (enums != "0" && enums != "1" && enums != "2") ||
+	    (used_types != "0" && used_types != "1")) {
+		fprintf(stderr, "Ignoring malformed request\n");
+		return;
+	}
+	request.enums = (enum_style)atoi(enums.c_str());
+	request.used_types = used_types == "1";
+
+	printf("Generating bindings for %s with namespace '%s'\n", request.api_name.c_str(), request.prefix.c_str());
+
+	std::string error;
+	bindings result;
+	bool loaded;
+	const registry *reg = lookup_registry(cache, request, srcdir, default_srcdir, threads,
+			&result.registry_file, &loaded, &error);
+	if (!reg) {
+		fprintf(stderr, "%s\n", error.c_str());
+		send_field(fd, std::string("error"));
+		send_field(fd, error);
+		return;
+	}
+	generate_bindings(*reg, request.prefix.c_str(), request.enums, request.used_types, false, threads, &result);
+	if (!loaded)
+		result.parse_time = result.build_time = 0;
+
+	char hash[32];
+	snprintf(hash, sizeof(hash), "%08x%08x", (unsigned int)(result.registry_hash >> 32), (unsigned int)result.registry_hash);
+	send_field(fd, std::string("ok")) &&
+		send_field(fd, result.variant_name) &&
+		send_field(fd, result.print_name) &&
+		send_field(fd, result.registry_file) &&
+		send_field(fd, std::string(hash)) &&
+		send_field(fd, result.header) &&
+		send_field(fd, result.source) &&
+		send_field(fd, result.parse_time) &&
+		send_field(fd, result.build_time) &&
+		send_field(fd, result.emit_time);
+}
+
+static volatile sig_atomic_t g_stop_server;
+
+static void stop_server(int)
+{
+	g_stop_server = 1;
+}
+
+//
+//Remove a socket left behind by a server that is gone. Fails if the path
+//is something else or a server still answers on it.
+//
+static bool remove_stale_socket(const char *socket_name, const struct sockaddr_un &addr)
+{
+	struct stat st;
+	if (lstat(socket_name, &st))
+		return errno == ENOENT;
+	if (!S_ISSOCK(st.st_mode)) {
+		fprintf(stderr, "'%s' exists and is not a socket\n", socket_name);
+		return false;
+	}
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		fprintf(stderr, "Error creating socket: %s\n", strerror(errno));
+		return false;
+	}
+	bool running = !connect(fd, (const struct sockaddr *)&addr, sizeof(addr));
+	close(fd);
+	if (running) {
+		fprintf(stderr, "A server is already running on '%s'\n", socket_name);
+		return false;
+	}
+	unlink(socket_name);
+	return true;
+}
+
+static void set_timeouts(int fd)
+{
+	struct timeval timeout;
+	timeout.tv_sec = CLIENT_TIMEOUT;
+	timeout.tv_usec = 0;
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+bool run_server(const char *socket_name, const char *srcdir, const char *default_srcdir, unsigned int threads)
+{
+	struct sockaddr_un addr;
+	if (!make_address(socket_name, &addr) || !remove_stale_socket(socket_name, addr))
+		return false;
+
+	int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listen_fd < 0) {
+		fprintf(stderr, "Error creating socket: %s\n", strerror(errno));
+		return false;
+	}
+	if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) || listen(listen_fd, 64)) {
+		fprintf(stderr, "Error listening on '%s': %s\n", socket_name, strerror(errno));
+		close(listen_fd);
+		return false;
+	}
+
+	//accept() must be interrupted by these so they are installed without
+	//SA_RESTART
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = stop_server;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	printf("Listening on %s\n", socket_name);
+
+	registry_cache_type cache;
+	while (!g_stop_server) {
+		int fd = accept(listen_fd, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			fprintf(stderr, "accept() failed: %s\n", strerror(errno));
+			break;
+		}
+		set_timeouts(fd);
+		handle_request(fd, cache, srcdir, default_srcdir, threads);
+		close(fd);
+	}
+
+	close(listen_fd);
+	unlink(socket_name);
+	FOREACH (iter, cache, registry_cache_type)
+		delete iter->second.reg;
+	return true;
+}
+
+bool request_bindings(const char *socket_name, const bindings_request &request, bindings *result, std::string *error)
+{
+	struct sockaddr_un addr;
+	if (!make_address(socket_name, &addr)) {
+		*error = "Invalid socket path";
+		return false;
+	}
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+		*error = std::string("Error connecting to '") + socket_name + "': " + strerror(errno);
+		if (fd >= 0)
+			close(fd);
+		return false;
+	}
+	signal(SIGPIPE, SIG_IGN);
+
+	std::string status, hash;
+	bool ok = send_field(fd, std::string(PROTOCOL_NAME)) &&
+		send_field(fd, request.api_name) &&
+		send_field(fd, request.prefix) &&
+		send_field(fd, (int)request.enums) &&
+		send_field(fd, (int)request.used_types) &&
+		send_field(fd, request.srcdir) &&
+		recv_field(fd, &status);
+	if (ok && status != "ok") {
+		if (!recv_field(fd, error))
+			*error = "Server failed to generate bindings";
+		close(fd);
+		return false;
+	}
+	ok = ok && recv_field(fd, &result->variant_name) &&
+		recv_field(fd, &result->print_name) &&
+		recv_field(fd, &result->registry_file) &&
+		recv_field(fd, &hash) &&
+		recv_field(fd, &result->header) &&
+		recv_field(fd, &result->source) &&
+		recv_field(fd, &result->parse_time) &&
+		recv_field(fd, &result->build_time) &&
+		recv_field(fd, &result->emit_time);
+	close(fd);
+	if (!ok) {
+		*error = std::string("Lost connection to '") + socket_name + "'";
+		return false;
+	}
+	result->registry_hash = strtoull(hash.c_str(), NULL, 16);
+	return true;
+}
+
+#else
+
+bool run_server(const char *socket_name, const char *srcdir, const char *default_srcdir, unsigned int threads)
+{
+	fprintf(stderr, "Server mode is not supported on this platform\n");
+	return false;
+}
+
+bool request_bindings(const char *socket_name, const bindings_request &request, bindings *result, std::string *error)
+{
+	*error = "Client mode is not supported on this platform";
+	return false;
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef GLBINDIFY_SERVER_H
+#define GLBINDIFY_SERVER_H
+
+//
+//Generator server: keeps parsed registries loaded and answers generation
+//requests from 'glbindify --connect' over a local socket
+//
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "glbindify.h"
+
+struct bindings_request {
+	std::string api_name;
+	std::string prefix;
+	glbindify::enum_style enums;
+	bool used_types;
+
+	//Directory holding the registry. Empty to use the server's default.
+	std::string srcdir;
+
+	bindings_request() : enums(glbindify::ENUM_STYLE_MACRO), used_types(false) {}
+};
+
+struct bindings {
+	std::string variant_name;
+	std::string print_name;
+
+	//Registry file the bindings were generated from, empty if the tables
+	//compiled into the executable were used
+	std::string registry_file;
+	uint64_t registry_hash;
+
+	std::string header;
+	std::string source;
+
+	//Headers of split bindings and their contents, named relative to the
+	//main header
+	std::vector<std::pair<std::string, std::string> > split_headers;
+
+	double parse_time;
+	double build_time;
+	double emit_time;
+};
+
+//
+//Load the registry for an API from 'srcdir', or from the tables compiled into
+//the executable if 'srcdir' is NULL and there are any. Otherwise it is read
+//from 'default_srcdir' using 'threads' parse threads. Sets 'registry_file'
+//to the file that was read. 'pipeline' is passed on to registry::load_file().
+//
+glbindify::registry *load_registry(const char *api_name, const char *srcdir, const char *default_srcdir,
+		unsigned int threads, const glbindify::options *pipeline, std::string *registry_file,
+		std::string *error);
+
+//
+//Generate bindings without the leading comments, formatting them with
+//'threads' threads. With 'split' they are split as bindify_split() does.
+//'used_types' is passed on as options::used_types.
+//
+void generate_bindings(const glbindify::registry &reg, const char *prefix, glbindify::enum_style enums,
+		bool used_types, bool split, unsigned int threads, bindings *result);
+
+//
+//Serve requests on the socket at 'socket_name' until interrupted. Requests
+//that do not name a source directory use 'srcdir' as load_registry() does.
+//Registries are reloaded when their file changes. Returns false if the
+//socket could not be set up.
+//
+bool run_server(const char *socket_name, const char *srcdir, const char *default_srcdir, unsigned int threads);
+
+//
+//Have the server listening at 'socket_name' generate bindings
+//
+bool request_bindings(const char *socket_name, const bindings_request &request, bindings *result, std::string *error);
+
+#endif
@@ -0,0 +1,87 @@
+//
+// Run by 'make check'. Rewrites the attributes of a document parsed in arena
+// mode, as registry.cpp parses them, and checks that clearing the document
+// frees the strings the new values were copied into.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include "tinyxml2.h"
+
+using namespace tinyxml2;
+
+#if __cplusplus < 201103L
+#define THROWS_BAD_ALLOC throw(std::bad_alloc)
+#define THROWS_NOTHING throw()
+#else
+#define THROWS_BAD_ALLOC
+#define THROWS_NOTHING noexcept
+#endif
+
+//tinyxml2 allocates copied strings with new[], count the ones still alive
+static int live_arrays;
+
+void *operator new[](size_t size) THROWS_BAD_ALLOC
+{
+	void *p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	live_arrays++;
+	return p;
+}
+
+void operator delete[](void *p) THROWS_NOTHING
+{
+	if (p)
+		live_arrays--;
+	free(p);
+}
+
+static int failures;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static const char *xml =
+	"<registry>"
+	"<type name=\"GLenum\" api=\"gl\" requires=\"khrplatform\"/>"
+	"</registry>";
+
+int main()
+{
+	int before = live_arrays;
+	{
+		XMLDocument doc;
+		doc.SetArena(true);
+		check(doc.Parse(xml) == XML_NO_ERROR, "parsing the document");
+		XMLElement *type = doc.FirstChildElement("registry")->FirstChildElement("type");
+
+		type->SetAttribute("name", "GLbitfield");
+		type->SetAttribute("api", 2);
+		check(strcmp(type->Attribute("name"), "GLbitfield") == 0, "rewriting an attribute");
+		check(type->IntAttribute("api") == 2, "rewriting an attribute with a number");
+		check(strcmp(type->Attribute("requires"), "khrplatform") == 0, "keeping the other attributes");
+
+		doc.Clear();
+		check(live_arrays == before, "freeing the rewritten attributes on Clear()");
+
+		//Clear() forgets that strings were copied, so rewrite one again
+		check(doc.Parse(xml) == XML_NO_ERROR, "parsing the document again");
+		type = doc.FirstChildElement("registry")->FirstChildElement("type");
+		check(strcmp(type->Attribute("name"), "GLenum") == 0, "reading the parsed attribute");
+		type->SetAttribute("requires", "stddef");
+	}
+	check(live_arrays == before, "freeing the rewritten attributes with the document");
+
+	if (failures)
+		return 1;
+	printf("PASS\n");
+	return 0;
+}
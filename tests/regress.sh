@@ -0,0 +1,127 @@
+#!/bin/sh
+#
+# Regression check run by 'make check'. Generates the bindings of every API
+# with the default options, with '-e enum', '-e const', '-u' and with '-H',
+# compares them with the checksums in expected.cksum and compiles them with
+# -Wall -Wextra -Werror as C, and their headers as C++.
+#
+# Usage: regress.sh [--update]
+#
+# GLBINDIFY, SRCDIR (holding the registries), CC and CXX are taken from the
+# environment. With GPERF=yes the sources of the GL APIs contain the output
+# of gperf and are not compared. --update rewrites expected.cksum from the
+# current output, after an intended change of the output or the registries.
+#
+# The leading comment of each file, which names the glbindify version, is
+# not part of its checksum.
+#
+
+GLBINDIFY=${GLBINDIFY:-./glbindify}
+SRCDIR=${SRCDIR:-.}
+CC=${CC:-cc}
+CXX=${CXX:-c++}
+EGL_CFLAGS=${EGL_CFLAGS:-"-I/usr/include/EGL -I/usr/include/KHR"}
+EXPECTED=$(cd "$(dirname "$0")" && pwd)/expected.cksum
+
+case $GLBINDIFY in /*) ;; *) GLBINDIFY=$(pwd)/$GLBINDIFY ;; esac
+case $SRCDIR in /*) ;; *) SRCDIR=$(pwd)/$SRCDIR ;; esac
+
+WORKDIR=${TMPDIR:-/tmp}/glbindify-regress.$$
+mkdir -p "$WORKDIR" || exit 1
+trap 'rm -rf "$WORKDIR"' EXIT
+
+status=0
+
+for style in default enum const used split; do
+	case $style in
+	default) options= ;;
+	enum) options="-e enum" ;;
+	const) options="-e const" ;;
+	used) options=-u ;;
+	split) options=-H ;;
+	esac
+	mkdir "$WORKDIR/$style"
+	for api in gl gles2 egl glx wgl; do
+		(cd "$WORKDIR/$style" && "$GLBINDIFY" -r -a $api -s "$SRCDIR" $options > /dev/null) || {
+			echo "FAIL: glbindify -a $api $options"
+			status=1
+		}
+	done
+done
+
+#
+# Compare the output with the expected checksums
+#
+(cd "$WORKDIR" && find default enum const used split -type f | LC_ALL=C sort | while read file; do
+	echo "$(sed '1,/^$/d' "$file" | cksum) $file"
+done) > "$WORKDIR/actual.cksum"
+
+if [ "$1" = "--update" ]; then
+	cp "$WORKDIR/actual.cksum" "$EXPECTED" || exit 1
+	echo "Updated $EXPECTED"
+	exit $status
+fi
+
+filter=cat
+if [ "$GPERF" = yes ]; then
+	echo "SKIP: comparing glcore.c and gles2.c, which embed the output of gperf"
+	filter="grep -v -e /glcore\.c$ -e /gles2\.c$"
+fi
+$filter "$EXPECTED" > "$WORKDIR/expected.cksum"
+$filter "$WORKDIR/actual.cksum" > "$WORKDIR/compared.cksum"
+if ! diff "$WORKDIR/expected.cksum" "$WORKDIR/compared.cksum" > "$WORKDIR/cksum.diff"; then
+	echo "FAIL: output differs from $EXPECTED in:"
+	grep '^[<>]' "$WORKDIR/cksum.diff" | awk '{ print "  " $4 }' | LC_ALL=C sort -u
+	status=1
+fi
+
+#
+# Compile the output of the APIs whose platform headers are available. The
+# C++ check enables everything the way the generated source does.
+#
+can_compile() {
+	echo "#include <$1>" > "$WORKDIR/probe.c"
+	$CC $2 -c "$WORKDIR/probe.c" -o "$WORKDIR/probe.o" > /dev/null 2>&1
+}
+
+variants="glcore gles2"
+if can_compile X11/Xlib.h; then
+	variants="$variants glx"
+else
+	echo "SKIP: compiling glx, X11 headers not found"
+fi
+if can_compile eglplatform.h "$EGL_CFLAGS"; then
+	variants="$variants egl"
+else
+	echo "SKIP: compiling egl, EGL headers not found"
+fi
+echo "SKIP: compiling wgl, which needs windows.h"
+
+for style in default enum const used split; do
+	dir=$WORKDIR/$style
+	for variant in $variants; do
+		$CC -std=c99 -Wall -Wextra -Werror $EGL_CFLAGS -I"$dir" -c "$dir/$variant.c" -o "$WORKDIR/out.o" || {
+			echo "FAIL: compiling $style/$variant.c"
+			status=1
+		}
+		(grep -e '^#undef ' -e '^#define ' "$dir/$variant.c"; echo "#include \"$variant.h\"") > "$WORKDIR/header.cpp"
+		$CXX -Wall -Wextra -Werror $EGL_CFLAGS -I"$dir" -c "$WORKDIR/header.cpp" -o "$WORKDIR/out.o" || {
+			echo "FAIL: compiling $style/$variant.h as C++"
+			status=1
+		}
+
+		#Every split header, included without the macros that select them
+		if [ -d "$dir/$variant" ]; then
+			for header in "$dir/$variant"/*.h; do
+				echo "#include \"$variant/$(basename "$header")\""
+			done > "$WORKDIR/split.c"
+			$CC -std=c99 -Wall -Wextra -Werror $EGL_CFLAGS -I"$dir" -c "$WORKDIR/split.c" -o "$WORKDIR/out.o" || {
+				echo "FAIL: compiling the split headers of $variant"
+				status=1
+			}
+		fi
+	done
+done
+
+[ $status = 0 ] && echo "PASS"
+exit $status
@@ -0,0 +1,203 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(HAVE_PTHREAD_H)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "thread.h"
+
+namespace glbindify {
+
+struct thread::impl {
+#if defined(_WIN32)
+	HANDLE handle;
+#elif defined(HAVE_PTHREAD_H)
+	pthread_t handle;
+#endif
+	bool started;
+};
+
+thread::thread() : m_impl(new impl())
+{
+	m_impl->started = false;
+}
+
+thread::~thread()
+{
+	join();
+	delete m_impl;
+}
+
+void *thread::entry(void *arg)
+{
+	((thread *)arg)->run();
+	return 0;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI win32_entry(LPVOID arg)
+{
+	thread::entry(arg);
+	return 0;
+}
+#endif
+
+bool thread::try_start()
+{
+#if defined(_WIN32)
+	m_impl->handle = CreateThread(NULL, 0, win32_entry, this, 0, NULL);
+	m_impl->started = m_impl->handle != NULL;
+#elif defined(HAVE_PTHREAD_H)
+	m_impl->started = !pthread_create(&m_impl->handle, NULL, entry, this);
+#endif
+	return m_impl->started;
+}
+
+void thread::start()
+{
+	if (!try_start())
+		run();
+}
+
+bool thread::supported()
+{
+#if defined(_WIN32) || defined(HAVE_PTHREAD_H)
+	return true;
+#else
+	return false;
+#endif
+}
+
+void thread::join()
+{
+	if (!m_impl->started)
+		return;
+#if defined(_WIN32)
+	WaitForSingleObject(m_impl->handle, INFINITE);
+	CloseHandle(m_impl->handle);
+#elif defined(HAVE_PTHREAD_H)
+	pthread_join(m_impl->handle, NULL);
+#endif
+	m_impl->started = false;
+}
+
+//
+//Without threads nothing ever waits, so these do nothing
+//
+struct mutex::impl {
+#if defined(_WIN32)
+	CRITICAL_SECTION handle;
+#elif defined(HAVE_PTHREAD_H)
+	pthread_mutex_t handle;
+#endif
+};
+
+mutex::mutex() : m_impl(new impl())
+{
+#if defined(_WIN32)
+	InitializeCriticalSection(&m_impl->handle);
+#elif defined(HAVE_PTHREAD_H)
+	pthread_mutex_init(&m_impl->handle, NULL);
+#endif
+}
+
+mutex::~mutex()
+{
+#if defined(_WIN32)
+	DeleteCriticalSection(&m_impl->handle);
+#elif defined(HAVE_PTHREAD_H)
+	pthread_mutex_destroy(&m_impl->handle);
+#endif
+	delete m_impl;
+}
+
+void mutex::lock()
+{
+#if defined(_WIN32)
+	EnterCriticalSection(&m_impl->handle);
+#elif defined(HAVE_PTHREAD_H)
+	pthread_mutex_lock(&m_impl->handle);
+#endif
+}
+
+void mutex::unlock()
+{
+#if defined(_WIN32)
+	LeaveCriticalSection(&m_impl->handle);
+#elif defined(HAVE_PTHREAD_H)
+	pthread_mutex_unlock(&m_impl->handle);
+#endif
+}
+
+struct condition::impl {
+#if defined(_WIN32)
+	CONDITION_VARIABLE handle;
+#elif defined(HAVE_PTHREAD_H)
+	pthread_cond_t handle;
+#endif
+};
+
+condition::condition() : m_impl(new impl())
+{
+#if defined(_WIN32)
+	InitializeConditionVariable(&m_impl->handle);
+#elif defined(HAVE_PTHREAD_H)
+	pthread_cond_init(&m_impl->handle, NULL);
+#endif
+}
+
+condition::~condition()
+{
+#if defined(HAVE_PTHREAD_H) && !defined(_WIN32)
+	pthread_cond_destroy(&m_impl->handle);
+#endif
+	delete m_impl;
+}
+
+void condition::wait(mutex &lock)
+{
+#if defined(_WIN32)
+	SleepConditionVariableCS(&m_impl->handle, &lock.m_impl->handle, INFINITE);
+#elif defined(HAVE_PTHREAD_H)
+	pthread_cond_wait(&m_impl->handle, &lock.m_impl->handle);
+#endif
+}
+
+void condition::signal()
+{
+#if defined(_WIN32)
+	WakeConditionVariable(&m_impl->handle);
+#elif defined(HAVE_PTHREAD_H)
+	pthread_cond_signal(&m_impl->handle);
+#endif
+}
+
+void condition::broadcast()
+{
+#if defined(_WIN32)
+	WakeAllConditionVariable(&m_impl->handle);
+#elif defined(HAVE_PTHREAD_H)
+	pthread_cond_broadcast(&m_impl->handle);
+#endif
+}
+
+unsigned int processor_count()
+{
+#if defined(_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+#elif defined(HAVE_PTHREAD_H) && defined(_SC_NPROCESSORS_ONLN)
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? count : 1;
+#else
+	return 1;
+#endif
+}
+
+}
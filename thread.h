@@ -0,0 +1,81 @@
+#ifndef GLBINDIFY_THREAD_H
+#define GLBINDIFY_THREAD_H
+
+namespace glbindify {
+
+//
+//Minimal threads on top of pthreads or Win32. Without either, a thread runs
+//to completion when it is started.
+//
+class thread {
+public:
+	thread();
+
+	//join() must be called before a derived class is destroyed, as run()
+	//may not have been entered yet
+	virtual ~thread();
+
+	//Run 'run()' on a new thread. Falls back to running it on the
+	//calling thread if no thread can be created.
+	void start();
+
+	//Run 'run()' on a new thread. Returns false without running it if no
+	//thread can be created.
+	bool try_start();
+	void join();
+
+	//Whether threads can run concurrently on this platform
+	static bool supported();
+
+	//Start routine handed to the platform
+	static void *entry(void *arg);
+protected:
+	virtual void run() = 0;
+private:
+	struct impl;
+	impl *m_impl;
+
+	thread(const thread &);
+	thread &operator=(const thread &);
+};
+
+class mutex {
+public:
+	mutex();
+	~mutex();
+	void lock();
+	void unlock();
+private:
+	struct impl;
+	impl *m_impl;
+	friend class condition;
+
+	mutex(const mutex &);
+	mutex &operator=(const mutex &);
+};
+
+class condition {
+public:
+	condition();
+	~condition();
+
+	//'lock' must be held by the caller
+	void wait(mutex &lock);
+	void signal();
+	void broadcast();
+private:
+	struct impl;
+	impl *m_impl;
+
+	condition(const condition &);
+	condition &operator=(const condition &);
+};
+
+//
+//Number of processors online, at least 1
+//
+unsigned int processor_count();
+
+}
+
+#endif
@@ -30,6 +30,22 @@ distribution.
 #   include <cstddef>
 #endif
 
+// Define TIXML_NO_SIMD to build only the scalar scanners
+#if !defined(TIXML_NO_SIMD) && ( defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 ) )
+#   define TIXML_SSE2
+#   include <emmintrin.h>
+#   if defined(__GNUC__) && ( __GNUC__ > 4 || ( __GNUC__ == 4 && __GNUC_MINOR__ >= 9 ) || defined(__clang__) )
+#       define TIXML_AVX2
+#       define TIXML_TARGET_AVX2 __attribute__((target("avx2")))
+#       include <immintrin.h>
+#   elif defined(_MSC_VER) && _MSC_VER >= 1700
+#       define TIXML_AVX2
+#       define TIXML_TARGET_AVX2
+#       include <immintrin.h>
+#       include <intrin.h>
+#   endif
+#endif
+
 static const char LINE_FEED				= (char)0x0a;			// all line endings are normalized to LF
 static const char LF = LINE_FEED;
 static const char CARRIAGE_RETURN		= (char)0x0d;			// CR gets filtered out
@@ -48,6 +64,297 @@ static const unsigned char TIXML_UTF_LEAD_2 = 0xbfU;
 namespace tinyxml2
 {
 
+/*
+	Scanning for delimiters, whitespace and the end of names. The registries
+	are megabytes of mostly plain text, so these compare 16 or 32 bytes at a
+	time where the processor can. Blocks are read from aligned addresses and
+	only ever within a parse buffer, which starts on a block boundary and is
+	padded with nulls to the end of the block holding its terminator.
+*/
+typedef const char* (*FindCharFunc)( const char* p, char c );
+typedef const char* (*SkipFunc)( const char* p );
+
+// First 'c' or null at or after p
+static const char* FindCharScalar( const char* p, char c )
+{
+    while ( *p && *p != c ) {
+        ++p;
+    }
+    return p;
+}
+
+// First byte that isn't " \t\n\v\f\r"
+static const char* SkipWhiteSpaceScalar( const char* p )
+{
+    while ( *p == ' ' || ( *p >= '\t' && *p <= '\r' ) ) {
+        ++p;
+    }
+    return p;
+}
+
+// First byte that XMLUtil::IsNameChar() rejects
+static const char* SkipNameCharsScalar( const char* p )
+{
+    while ( *p && XMLUtil::IsNameChar( *p ) ) {
+        ++p;
+    }
+    return p;
+}
+
+#ifdef TIXML_SSE2
+static inline int LowestBit( unsigned int mask )
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward( &index, mask );
+    return (int)index;
+#else
+    return __builtin_ctz( mask );
+#endif
+}
+
+// Bytes of v in [lo, lo + count)
+static inline __m128i InRange128( __m128i v, char lo, char count )
+{
+    __m128i x = _mm_sub_epi8( v, _mm_set1_epi8( lo ) );
+    return _mm_and_si128( _mm_cmpgt_epi8( x, _mm_set1_epi8( -1 ) ), _mm_cmplt_epi8( x, _mm_set1_epi8( count ) ) );
+}
+
+static inline unsigned int FindCharMask128( __m128i v, char c )
+{
+    return _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( c ) ), _mm_cmpeq_epi8( v, _mm_setzero_si128() ) ) );
+}
+
+static inline unsigned int NotWhiteSpaceMask128( __m128i v )
+{
+    __m128i ws = _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( ' ' ) ), InRange128( v, '\t', 5 ) );
+    return ~_mm_movemask_epi8( ws ) & 0xffff;
+}
+
+static inline unsigned int NotNameCharMask128( __m128i v )
+{
+    __m128i name = _mm_cmplt_epi8( v, _mm_setzero_si128() );        // UTF-8
+    name = _mm_or_si128( name, InRange128( _mm_or_si128( v, _mm_set1_epi8( 0x20 ) ), 'a', 26 ) );
+    name = _mm_or_si128( name, InRange128( v, '0', 11 ) );            // digits and ':'
+    name = _mm_or_si128( name, InRange128( v, '-', 2 ) );             // '-' and '.'
+    name = _mm_or_si128( name, _mm_cmpeq_epi8( v, _mm_set1_epi8( '_' ) ) );
+    return ~_mm_movemask_epi8( name ) & 0xffff;
+}
+
+static const char* FindCharSSE2( const char* p, char c )
+{
+    size_t offset = (size_t)p & 15;
+    const char* block = p - offset;
+    unsigned int mask = FindCharMask128( _mm_load_si128( (const __m128i*)block ), c ) >> offset;
+    if ( mask ) {
+        return p + LowestBit( mask );
+    }
+    for ( ;; ) {
+        block += 16;
+        mask = FindCharMask128( _mm_load_si128( (const __m128i*)block ), c );
+        if ( mask ) {
+            return block + LowestBit( mask );
+        }
+    }
+}
+
+static const char* SkipWhiteSpaceSSE2( const char* p )
+{
+    size_t offset = (size_t)p & 15;
+    const char* block = p - offset;
+    unsigned int mask = NotWhiteSpaceMask128( _mm_load_si128( (const __m128i*)block ) ) >> offset;
+    if ( mask ) {
+        return p + LowestBit( mask );
+    }
+    for ( ;; ) {
+        block += 16;
+        mask = NotWhiteSpaceMask128( _mm_load_si128( (const __m128i*)block ) );
+        if ( mask ) {
+            return block + LowestBit( mask );
+        }
+    }
+}
+
+static const char* SkipNameCharsSSE2( const char* p )
+{
+    size_t offset = (size_t)p & 15;
+    const char* block = p - offset;
+    unsigned int mask = NotNameCharMask128( _mm_load_si128( (const __m128i*)block ) ) >> offset;
+    if ( mask ) {
+        return p + LowestBit( mask );
+    }
+    for ( ;; ) {
+        block += 16;
+        mask = NotNameCharMask128( _mm_load_si128( (const __m128i*)block ) );
+        if ( mask ) {
+            return block + LowestBit( mask );
+        }
+    }
+}
+#endif
+
+#ifdef TIXML_AVX2
+TIXML_TARGET_AVX2 static inline __m256i InRange256( __m256i v, char lo, char count )
+{
+    __m256i x = _mm256_sub_epi8( v, _mm256_set1_epi8( lo ) );
+    return _mm256_and_si256( _mm256_cmpgt_epi8( x, _mm256_set1_epi8( -1 ) ), _mm256_cmpgt_epi8( _mm256_set1_epi8( count ), x ) );
+}
+
+TIXML_TARGET_AVX2 static inline unsigned int FindCharMask256( __m256i v, char c )
+{
+    return (unsigned int)_mm256_movemask_epi8( _mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( c ) ), _mm256_cmpeq_epi8( v, _mm256_setzero_si256() ) ) );
+}
+
+TIXML_TARGET_AVX2 static inline unsigned int NotWhiteSpaceMask256( __m256i v )
+{
+    __m256i ws = _mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( ' ' ) ), InRange256( v, '\t', 5 ) );
+    return ~(unsigned int)_mm256_movemask_epi8( ws );
+}
+
+TIXML_TARGET_AVX2 static inline unsigned int NotNameCharMask256( __m256i v )
+{
+    __m256i name = _mm256_cmpgt_epi8( _mm256_setzero_si256(), v );    // UTF-8
+    name = _mm256_or_si256( name, InRange256( _mm256_or_si256( v, _mm256_set1_epi8( 0x20 ) ), 'a', 26 ) );
+    name = _mm256_or_si256( name, InRange256( v, '0', 11 ) );
+    name = _mm256_or_si256( name, InRange256( v, '-', 2 ) );
+    name = _mm256_or_si256( name, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '_' ) ) );
+    return ~(unsigned int)_mm256_movemask_epi8( name );
+}
+
+TIXML_TARGET_AVX2 static const char* FindCharAVX2( const char* p, char c )
+{
+    size_t offset = (size_t)p & 31;
+    const char* block = p - offset;
+    unsigned int mask = FindCharMask256( _mm256_load_si256( (const __m256i*)block ), c ) >> offset;
+    if ( mask ) {
+        return p + LowestBit( mask );
+    }
+    for ( ;; ) {
+        block += 32;
+        mask = FindCharMask256( _mm256_load_si256( (const __m256i*)block ), c );
+        if ( mask ) {
+            return block + LowestBit( mask );
+        }
+    }
+}
+
+TIXML_TARGET_AVX2 static const char* SkipWhiteSpaceAVX2( const char* p )
+{
+    size_t offset = (size_t)p & 31;
+    const char* block = p - offset;
+    unsigned int mask = NotWhiteSpaceMask256( _mm256_load_si256( (const __m256i*)block ) ) >> offset;
+    if ( mask ) {
+        return p + LowestBit( mask );
+    }
+    for ( ;; ) {
+        block += 32;
+        mask = NotWhiteSpaceMask256( _mm256_load_si256( (const __m256i*)block ) );
+        if ( mask ) {
+            return block + LowestBit( mask );
+        }
+    }
+}
+
+TIXML_TARGET_AVX2 static const char* SkipNameCharsAVX2( const char* p )
+{
+    size_t offset = (size_t)p & 31;
+    const char* block = p - offset;
+    unsigned int mask = NotNameCharMask256( _mm256_load_si256( (const __m256i*)block ) ) >> offset;
+    if ( mask ) {
+        return p + LowestBit( mask );
+    }
+    for ( ;; ) {
+        block += 32;
+        mask = NotNameCharMask256( _mm256_load_si256( (const __m256i*)block ) );
+        if ( mask ) {
+            return block + LowestBit( mask );
+        }
+    }
+}
+
+static bool HasAVX2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid( info, 0 );
+    if ( info[0] < 7 ) {
+        return false;
+    }
+    __cpuid( info, 1 );
+    // The OS must save the AVX registers
+    if ( !( info[2] & ( 1 << 27 ) ) || ( _xgetbv( 0 ) & 6 ) != 6 ) {
+        return false;
+    }
+    __cpuidex( info, 7, 0 );
+    return ( info[1] & ( 1 << 5 ) ) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+}
+#endif
+
+struct Scanner {
+    FindCharFunc findChar;
+    SkipFunc skipWhiteSpace;
+    SkipFunc skipNameChars;
+};
+
+static Scanner ChooseScanner()
+{
+    Scanner scanner = { FindCharScalar, SkipWhiteSpaceScalar, SkipNameCharsScalar };
+#ifdef TIXML_SSE2
+    scanner.findChar = FindCharSSE2;
+    scanner.skipWhiteSpace = SkipWhiteSpaceSSE2;
+    scanner.skipNameChars = SkipNameCharsSSE2;
+#endif
+#ifdef TIXML_AVX2
+    if ( HasAVX2() ) {
+        scanner.findChar = FindCharAVX2;
+        scanner.skipWhiteSpace = SkipWhiteSpaceAVX2;
+        scanner.skipNameChars = SkipNameCharsAVX2;
+    }
+#endif
+    return scanner;
+}
+
+// Chosen on first use, which may be from another static constructor
+static const Scanner& GetScanner()
+{
+    static const Scanner scanner = ChooseScanner();
+    return scanner;
+}
+
+// ScanWhiteSpace() within a parse buffer
+static const char* ScanWhiteSpace( const char* p )
+{
+    return XMLUtil::IsWhiteSpace( *p ) ? GetScanner().skipWhiteSpace( p ) : p;
+}
+
+static char* ScanWhiteSpace( char* p )
+{
+    return XMLUtil::IsWhiteSpace( *p ) ? const_cast<char*>( GetScanner().skipWhiteSpace( p ) ) : p;
+}
+
+static const size_t SCAN_BLOCK = 32;
+
+char* XMLUtil::NewParseBuffer( size_t len )
+{
+    // The byte before the buffer holds its offset into the allocation
+    char* mem = new char[ len + 2*SCAN_BLOCK ];
+    char* buffer = mem + SCAN_BLOCK - ( (size_t)mem & ( SCAN_BLOCK - 1 ) );
+    buffer[-1] = (char)( buffer - mem );
+    memset( buffer + len, 0, SCAN_BLOCK );
+    return buffer;
+}
+
+void XMLUtil::DeleteParseBuffer( char* buffer )
+{
+    if ( buffer ) {
+        delete [] ( buffer - (unsigned char)buffer[-1] );
+    }
+}
+
 struct Entity {
     const char* pattern;
     int length;
@@ -101,8 +408,8 @@ char* StrPair::ParseText( char* p, const char* endTag, int strFlags )
     size_t length = strlen( endTag );
 
     // Inner loop of text parsing.
-    while ( *p ) {
-        if ( *p == endChar && strncmp( p, endTag, length ) == 0 ) {
+    while ( *( p = const_cast<char*>( GetScanner().findChar( p, endChar ) ) ) ) {
+        if ( strncmp( p, endTag, length ) == 0 ) {
             Set( start, p, strFlags );
             return p + length;
         }
@@ -120,15 +427,12 @@ char* StrPair::ParseName( char* p )
         return 0;
     }
 
-    while( *p && ( p == start ? XMLUtil::IsNameStartChar( *p ) : XMLUtil::IsNameChar( *p ) )) {
-        ++p;
-    }
-
-    if ( p > start ) {
-        Set( start, p, 0 );
-        return p;
+    if ( !XMLUtil::IsNameStartChar( *p ) ) {
+        return 0;
     }
-    return 0;
+    p = const_cast<char*>( GetScanner().skipNameChars( p + 1 ) );
+    Set( start, p, 0 );
+    return p;
 }
 
 
@@ -137,7 +441,7 @@ void StrPair::CollapseWhitespace()
     // Adjusting _start would cause undefined behavior on delete[]
     TIXMLASSERT( ( _flags & NEEDS_DELETE ) == 0 );
     // Trim leading space.
-    _start = XMLUtil::SkipWhiteSpace( _start );
+    _start = ScanWhiteSpace( _start );
 
     if ( _start && *_start ) {
         char* p = _start;	// the read pointer
@@ -145,7 +449,7 @@ void StrPair::CollapseWhitespace()
 
         while( *p ) {
             if ( XMLUtil::IsWhiteSpace( *p )) {
-                p = XMLUtil::SkipWhiteSpace( p );
+                p = ScanWhiteSpace( p );
                 if ( *p == 0 ) {
                     break;    // don't write to q; this trims the trailing space.
                 }
@@ -167,7 +471,16 @@ const char* StrPair::GetStr()
         *_end = 0;
         _flags ^= NEEDS_FLUSH;
 
-        if ( _flags ) {
+        // Most values have no entities or carriage returns and are used
+        // where they were parsed
+        if ( ( _flags & NEEDS_ENTITY_PROCESSING ) && !memchr( _start, '&', _end - _start ) ) {
+            _flags &= ~NEEDS_ENTITY_PROCESSING;
+        }
+        if ( ( _flags & NEEDS_NEWLINE_NORMALIZATION ) && !memchr( _start, CR, _end - _start ) ) {
+            _flags &= ~NEEDS_NEWLINE_NORMALIZATION;
+        }
+
+        if ( _flags & ( NEEDS_ENTITY_PROCESSING | NEEDS_NEWLINE_NORMALIZATION ) ) {
             char* p = _start;	// the read pointer
             char* q = _start;	// the write pointer
 
@@ -235,11 +548,13 @@ const char* StrPair::GetStr()
                 }
             }
             *q = 0;
+            _end = q;
         }
         // The loop below has plenty going on, and this
         // is a less useful mode. Break it out.
         if ( _flags & COLLAPSE_WHITESPACE ) {
             CollapseWhitespace();
+            _end = _start + strlen( _start );
         }
         _flags = (_flags & NEEDS_DELETE);
     }
@@ -247,6 +562,20 @@ const char* StrPair::GetStr()
 }
 
 
+const char* StrPair::GetStr( size_t* length )
+{
+    const char* str = GetStr();
+    if ( !str ) {
+        *length = 0;
+    }
+    else {
+        // Interned strings have no end
+        *length = _end ? _end - _start : strlen( str );
+    }
+    return str;
+}
+
+
 
 
 // --------- XMLUtil ----------- //
@@ -481,7 +810,7 @@ char* XMLDocument::Identify( char* p, XMLNode** node )
 {
     XMLNode* returnNode = 0;
     char* start = p;
-    p = XMLUtil::SkipWhiteSpace( p );
+    p = ScanWhiteSpace( p );
     if( !p || !*p ) {
         return p;
     }
@@ -560,11 +889,79 @@ bool XMLDocument::Accept( XMLVisitor* visitor ) const
 }
 
 
+// --------- MemArena ----------- //
+void MemArena::NewChunk( int size )
+{
+    size_t bytes = sizeof( Chunk ) + ( size > CHUNK_SIZE ? size : CHUNK_SIZE );
+    Chunk* chunk = reinterpret_cast<Chunk*>( new char[bytes] );
+    chunk->next = _chunk;
+    _chunk = chunk;
+    _top = reinterpret_cast<char*>( chunk + 1 );
+    _end = reinterpret_cast<char*>( chunk ) + bytes;
+}
+
+
+void MemArena::Clear()
+{
+    while ( _chunk ) {
+        Chunk* next = _chunk->next;
+        delete [] reinterpret_cast<char*>( _chunk );
+        _chunk = next;
+    }
+    _top = _end = 0;
+}
+
+
+// --------- NameTable ----------- //
+
+NameTable::NameTable() : _names( 0 )
+{
+    memset( _table, 0, sizeof( _table ) );
+}
+
+
+static inline unsigned int NameHash( const char* name, size_t length )
+{
+    return (unsigned char)name[0] * 31 + (unsigned char)name[length - 1] * 7 + (unsigned int)length;
+}
+
+
+void NameTable::Set( const char* const* names, int count )
+{
+    TIXMLASSERT( count <= 256 );
+    _names = names;
+    memset( _table, 0, sizeof( _table ) );
+    for ( int i = 1; i < count; ++i ) {
+        unsigned int h = NameHash( names[i], strlen( names[i] ) ) & ( SIZE - 1 );
+        while ( _table[h] ) {
+            h = ( h + 1 ) & ( SIZE - 1 );
+        }
+        _table[h] = (unsigned char)i;
+    }
+}
+
+
+int NameTable::Lookup( const char* name, size_t length ) const
+{
+    if ( !_names || !length ) {
+        return 0;
+    }
+    for ( unsigned int h = NameHash( name, length ) & ( SIZE - 1 ); _table[h]; h = ( h + 1 ) & ( SIZE - 1 ) ) {
+        const char* known = _names[_table[h]];
+        if ( strncmp( known, name, length ) == 0 && known[length] == 0 ) {
+            return _table[h];
+        }
+    }
+    return 0;
+}
+
+
 // --------- XMLNode ----------- //
 
 XMLNode::XMLNode( XMLDocument* doc ) :
     _document( doc ),
     _parent( 0 ),
+    _tagId( 0 ),
     _firstChild( 0 ), _lastChild( 0 ),
     _prev( 0 ), _next( 0 ),
     _memPool( 0 )
@@ -585,6 +982,12 @@ const char* XMLNode::Value() const
     return _value.GetStr();
 }
 
+
+const char* XMLNode::Value( size_t* length ) const
+{
+    return _value.GetStr( length );
+}
+
 void XMLNode::SetValue( const char* str, bool staticMem )
 {
     if ( staticMem ) {
@@ -592,6 +995,7 @@ void XMLNode::SetValue( const char* str, bool staticMem )
     }
     else {
         _value.SetStr( str );
+        _document->_ownsStrings = true;
     }
 }
 
@@ -809,6 +1213,7 @@ char* XMLNode::ParseDeep( char* p, StrPair* parentEnd )
         }
 
         StrPair endTag;
+        _document->_parseParent = this;
         p = node->ParseDeep( p, &endTag );
         if ( !p ) {
             DeleteNode( node );
@@ -820,6 +1225,11 @@ char* XMLNode::ParseDeep( char* p, StrPair* parentEnd )
         }
 
         XMLElement* ele = node->ToElement();
+        if ( ele && ele->ClosingType() == XMLElement::SKIPPED ) {
+            node->_memPool->SetTracked();	// created and then immediately deleted.
+            DeleteNode( node );
+            continue;
+        }
         // We read the end tag. Return it to the parent.
         if ( ele && ele->ClosingType() == XMLElement::CLOSING ) {
             if ( parentEnd ) {
@@ -1075,22 +1485,29 @@ const char* XMLAttribute::Value() const
     return _value.GetStr();
 }
 
-char* XMLAttribute::ParseDeep( char* p, bool processEntities )
+const char* XMLAttribute::Value( size_t* length ) const
+{
+    return _value.GetStr( length );
+}
+
+char* XMLAttribute::ParseDeep( char* p, bool processEntities, const NameTable& names )
 {
     // Parse using the name rules: bug fix, was using ParseText before
+    char* name = p;
     p = _name.ParseName( p );
     if ( !p || !*p ) {
         return 0;
     }
+    _nameId = names.Lookup( name, p - name );
 
     // Skip white space before =
-    p = XMLUtil::SkipWhiteSpace( p );
+    p = ScanWhiteSpace( p );
     if ( !p || *p != '=' ) {
         return 0;
     }
 
     ++p;	// move up to opening quote
-    p = XMLUtil::SkipWhiteSpace( p );
+    p = ScanWhiteSpace( p );
     if ( *p != '\"' && *p != '\'' ) {
         return 0;
     }
@@ -1106,6 +1523,7 @@ char* XMLAttribute::ParseDeep( char* p, bool processEntities )
 void XMLAttribute::SetName( const char* n )
 {
     _name.SetStr( n );
+    _document->_ownsStrings = true;
 }
 
 
@@ -1157,6 +1575,7 @@ XMLError XMLAttribute::QueryDoubleValue( double* value ) const
 void XMLAttribute::SetAttribute( const char* v )
 {
     _value.SetStr( v );
+    _document->_ownsStrings = true;
 }
 
 
@@ -1164,7 +1583,7 @@ void XMLAttribute::SetAttribute( int v )
 {
     char buf[BUF_SIZE];
     XMLUtil::ToStr( v, buf, BUF_SIZE );
-    _value.SetStr( buf );
+    SetAttribute( buf );
 }
 
 
@@ -1172,7 +1591,7 @@ void XMLAttribute::SetAttribute( unsigned v )
 {
     char buf[BUF_SIZE];
     XMLUtil::ToStr( v, buf, BUF_SIZE );
-    _value.SetStr( buf );
+    SetAttribute( buf );
 }
 
 
@@ -1180,21 +1599,21 @@ void XMLAttribute::SetAttribute( bool v )
 {
     char buf[BUF_SIZE];
     XMLUtil::ToStr( v, buf, BUF_SIZE );
-    _value.SetStr( buf );
+    SetAttribute( buf );
 }
 
 void XMLAttribute::SetAttribute( double v )
 {
     char buf[BUF_SIZE];
     XMLUtil::ToStr( v, buf, BUF_SIZE );
-    _value.SetStr( buf );
+    SetAttribute( buf );
 }
 
 void XMLAttribute::SetAttribute( float v )
 {
     char buf[BUF_SIZE];
     XMLUtil::ToStr( v, buf, BUF_SIZE );
-    _value.SetStr( buf );
+    SetAttribute( buf );
 }
 
 
@@ -1238,6 +1657,17 @@ const XMLAttribute* XMLElement::FindAttribute( const char* name ) const
 }
 
 
+const XMLAttribute* XMLElement::FindAttributeById( int nameId ) const
+{
+    for( XMLAttribute* a = _rootAttribute; a; a = a->_next ) {
+        if ( a->_nameId == nameId ) {
+            return a;
+        }
+    }
+    return 0;
+}
+
+
 const char* XMLElement::Attribute( const char* name, const char* value ) const
 {
     const XMLAttribute* a = FindAttribute( name );
@@ -1389,7 +1819,7 @@ XMLAttribute* XMLElement::FindOrCreateAttribute( const char* name )
         }
     }
     if ( !attrib ) {
-        attrib = new (_document->_attributePool.Alloc() ) XMLAttribute();
+        attrib = new (_document->_attributePool.Alloc() ) XMLAttribute( _document );
         attrib->_memPool = &_document->_attributePool;
         if ( last ) {
             last->_next = attrib;
@@ -1398,6 +1828,7 @@ XMLAttribute* XMLElement::FindOrCreateAttribute( const char* name )
             _rootAttribute = attrib;
         }
         attrib->SetName( name );
+        attrib->_nameId = _document->_attributeNames.Lookup( name, strlen( name ) );
         attrib->_memPool->SetTracked(); // always created and linked.
     }
     return attrib;
@@ -1430,7 +1861,7 @@ char* XMLElement::ParseAttributes( char* p )
 
     // Read the attributes.
     while( p ) {
-        p = XMLUtil::SkipWhiteSpace( p );
+        p = ScanWhiteSpace( p );
         if ( !p || !(*p) ) {
             _document->SetError( XML_ERROR_PARSING_ELEMENT, start, Name() );
             return 0;
@@ -1438,12 +1869,13 @@ char* XMLElement::ParseAttributes( char* p )
 
         // attribute.
         if (XMLUtil::IsNameStartChar( *p ) ) {
-            XMLAttribute* attrib = new (_document->_attributePool.Alloc() ) XMLAttribute();
+            XMLAttribute* attrib = new (_document->_attributePool.Alloc() ) XMLAttribute( _document );
             attrib->_memPool = &_document->_attributePool;
 			attrib->_memPool->SetTracked();
 
-            p = attrib->ParseDeep( p, _document->ProcessEntities() );
-            if ( !p || Attribute( attrib->Name() ) ) {
+            p = attrib->ParseDeep( p, _document->ProcessEntities(), _document->_attributeNames );
+            bool duplicate = p && ( attrib->_nameId ? FindAttributeById( attrib->_nameId ) != 0 : Attribute( attrib->Name() ) != 0 );
+            if ( !p || duplicate ) {
                 DeleteAttribute( attrib );
                 _document->SetError( XML_ERROR_PARSING_ATTRIBUTE, start, p );
                 return 0;
@@ -1496,7 +1928,7 @@ void XMLElement::DeleteAttribute( XMLAttribute* attribute )
 char* XMLElement::ParseDeep( char* p, StrPair* strPair )
 {
     // Read the element name.
-    p = XMLUtil::SkipWhiteSpace( p );
+    p = ScanWhiteSpace( p );
     if ( !p ) {
         return 0;
     }
@@ -1509,13 +1941,29 @@ char* XMLElement::ParseDeep( char* p, StrPair* strPair )
         ++p;
     }
 
+    char* name = p;
     p = _value.ParseName( p );
     if ( _value.Empty() ) {
         return 0;
     }
+    if ( !_closingType ) {
+        _tagId = _document->_tagNames.Lookup( name, p - name );
+    }
 
     p = ParseAttributes( p );
-    if ( !p || !*p || _closingType ) {
+    if ( !p || _closingType == CLOSING ) {
+        return p;
+    }
+
+    XMLParseFilter* filter = _document->_parseFilter;
+    if ( filter && !filter->Keep( *_document->_parseParent, *this ) ) {
+        if ( _closingType == OPEN ) {
+            p = SkipContent( p );
+        }
+        _closingType = SKIPPED;
+        return p;
+    }
+    if ( !*p || _closingType ) {
         return p;
     }
 
@@ -1524,6 +1972,80 @@ char* XMLElement::ParseDeep( char* p, StrPair* strPair )
 }
 
 
+static char* SkipPast( char* p, const char* str )
+{
+    size_t length = strlen( str );
+    while ( *( p = const_cast<char*>( GetScanner().findChar( p, *str ) ) ) ) {
+        if ( strncmp( p, str, length ) == 0 ) {
+            return p + length;
+        }
+        ++p;
+    }
+    return 0;
+}
+
+
+//
+//	Scan past the content and end tag of a skipped element. Only as much
+//	is understood as is needed to match up tags.
+//
+char* XMLElement::SkipContent( char* p )
+{
+    int depth = 1;
+    while ( p && *( p = const_cast<char*>( GetScanner().findChar( p, '<' ) ) ) ) {
+        if ( XMLUtil::StringEqual( p, "<!--", 4 ) ) {
+            p = SkipPast( p+4, "-->" );
+        }
+        else if ( XMLUtil::StringEqual( p, "<![CDATA[", 9 ) ) {
+            p = SkipPast( p+9, "]]>" );
+        }
+        else if ( *(p+1) == '?' ) {
+            p = SkipPast( p+2, "?>" );
+        }
+        else if ( *(p+1) == '!' ) {
+            p = SkipPast( p+2, ">" );
+        }
+        else if ( *(p+1) == '/' ) {
+            char* name = p+2;
+            p = SkipPast( name, ">" );
+            if ( p && --depth == 0 ) {
+                size_t length;
+                const char* value = _value.GetStr( &length );
+                if ( strncmp( name, value, length ) != 0 || XMLUtil::IsNameChar( name[length] ) ) {
+                    _document->SetError( XML_ERROR_MISMATCHED_ELEMENT, value, 0 );
+                    return 0;
+                }
+                return p;
+            }
+        }
+        else {
+            char quote = 0;
+            for ( ++p; *p; ++p ) {
+                if ( quote ) {
+                    if ( *p == quote ) {
+                        quote = 0;
+                    }
+                }
+                else if ( *p == '"' || *p == '\'' ) {
+                    quote = *p;
+                }
+                else if ( *p == '>' ) {
+                    break;
+                }
+            }
+            if ( !*p ) {
+                return 0;
+            }
+            if ( *(p-1) != '/' ) {
+                ++depth;
+            }
+            ++p;
+        }
+    }
+    return 0;
+}
+
+
 
 XMLNode* XMLElement::ShallowClone( XMLDocument* doc ) const
 {
@@ -1585,16 +2107,22 @@ XMLDocument::XMLDocument( bool processEntities, Whitespace whitespace ) :
     _whitespace( whitespace ),
     _errorStr1( 0 ),
     _errorStr2( 0 ),
-    _charBuffer( 0 )
+    _charBuffer( 0 ),
+    _arenaMode( false ),
+    _ownsStrings( false ),
+    _parseFilter( 0 ),
+    _parseParent( 0 )
 {
     _document = this;	// avoid warning about 'this' in initializer list
 }
 
 
+
+
 XMLDocument::~XMLDocument()
 {
-    DeleteChildren();
-    delete [] _charBuffer;
+    DeleteDOM();
+    XMLUtil::DeleteParseBuffer( _charBuffer );
 
 #if 0
     _textPool.Trace( "text" );
@@ -1604,7 +2132,7 @@ XMLDocument::~XMLDocument()
 #endif
 
 #ifdef DEBUG
-	if ( Error() == false ) {
+	if ( Error() == false && !_arenaMode ) {
 		TIXMLASSERT( _elementPool.CurrentAllocs()   == _elementPool.Untracked() );
 		TIXMLASSERT( _attributePool.CurrentAllocs() == _attributePool.Untracked() );
 		TIXMLASSERT( _textPool.CurrentAllocs()      == _textPool.Untracked() );
@@ -1614,15 +2142,41 @@ XMLDocument::~XMLDocument()
 }
 
 
+void XMLDocument::DeleteDOM()
+{
+    if ( _arenaMode && !_ownsStrings ) {
+        // Nodes own no memory outside the arena, so there is nothing to destroy.
+        _firstChild = _lastChild = 0;
+    }
+    else {
+        DeleteChildren();
+    }
+    _arena.Clear();
+    _ownsStrings = false;
+}
+
+
+void XMLDocument::SetArena( bool arena )
+{
+    TIXMLASSERT( !_firstChild );
+    MemArena* a = arena ? &_arena : 0;
+    _elementPool.SetArena( a );
+    _attributePool.SetArena( a );
+    _textPool.SetArena( a );
+    _commentPool.SetArena( a );
+    _arenaMode = arena;
+}
+
+
 void XMLDocument::Clear()
 {
-    DeleteChildren();
+    DeleteDOM();
 
     _errorID = XML_NO_ERROR;
     _errorStr1 = 0;
     _errorStr2 = 0;
 
-    delete [] _charBuffer;
+    XMLUtil::DeleteParseBuffer( _charBuffer );
     _charBuffer = 0;
 }
 
@@ -1632,6 +2186,7 @@ XMLElement* XMLDocument::NewElement( const char* name )
     XMLElement* ele = new (_elementPool.Alloc()) XMLElement( this );
     ele->_memPool = &_elementPool;
     ele->SetName( name );
+    ele->_tagId = _tagNames.Lookup( name, strlen( name ) );
     return ele;
 }
 
@@ -1723,7 +2278,7 @@ XMLError XMLDocument::LoadFile( FILE* fp )
         return _errorID;
     }
 
-    _charBuffer = new char[size+1];
+    _charBuffer = XMLUtil::NewParseBuffer( size );
     size_t read = fread( _charBuffer, 1, size, fp );
     if ( read != size ) {
         SetError( XML_ERROR_FILE_READ_ERROR, 0, 0 );
@@ -1733,7 +2288,7 @@ XMLError XMLDocument::LoadFile( FILE* fp )
     _charBuffer[size] = 0;
 
     const char* p = _charBuffer;
-    p = XMLUtil::SkipWhiteSpace( p );
+    p = ScanWhiteSpace( p );
     p = XMLUtil::ReadBOM( p, &_writeBOM );
     if ( !p || !*p ) {
         SetError( XML_ERROR_EMPTY_DOCUMENT, 0, 0 );
@@ -1768,7 +2323,6 @@ XMLError XMLDocument::SaveFile( FILE* fp, bool compact )
 
 XMLError XMLDocument::Parse( const char* p, size_t len )
 {
-	const char* start = p;
     Clear();
 
     if ( len == 0 || !p || !*p ) {
@@ -1778,18 +2332,18 @@ XMLError XMLDocument::Parse( const char* p, size_t len )
     if ( len == (size_t)(-1) ) {
         len = strlen( p );
     }
-    _charBuffer = new char[ len+1 ];
+    _charBuffer = XMLUtil::NewParseBuffer( len );
     memcpy( _charBuffer, p, len );
     _charBuffer[len] = 0;
 
-    p = XMLUtil::SkipWhiteSpace( p );
+    p = ScanWhiteSpace( _charBuffer );
     p = XMLUtil::ReadBOM( p, &_writeBOM );
     if ( !p || !*p ) {
         SetError( XML_ERROR_EMPTY_DOCUMENT, 0, 0 );
         return _errorID;
     }
 
-    ptrdiff_t delta = p - start;	// skip initial whitespace, BOM, etc.
+    ptrdiff_t delta = p - _charBuffer;	// skip initial whitespace, BOM, etc.
     ParseDeep( _charBuffer+delta, 0 );
     return _errorID;
 }
@@ -1833,6 +2387,159 @@ void XMLDocument::PrintError() const
 }
 
 
+// --------- XMLFrozenDocument ----------- //
+void XMLFrozenDocument::Freeze( XMLDocument* doc )
+{
+    TIXMLASSERT( !doc->_ownsStrings );
+    _nodes.Clear();
+    _attributes.Clear();
+    XMLUtil::DeleteParseBuffer( _charBuffer );
+    _charBuffer = doc->_charBuffer;
+
+    Node* root = _nodes.PushArr( 1 );
+    root->parent = root->firstChild = root->nextSibling = NONE;
+    root->value = root->length = 0;
+    root->firstAttribute = 0;
+    root->attributeCount = 0;
+    root->tagId = 0;
+    root->type = DOCUMENT;
+
+    unsigned prev = NONE;
+    for ( const XMLNode* node = doc->FirstChild(); node; node = node->NextSibling() ) {
+        unsigned index = Add( node, 0 );
+        if ( index == NONE ) {
+            continue;
+        }
+        if ( prev == NONE ) {
+            _nodes[0].firstChild = index;
+        }
+        else {
+            _nodes[prev].nextSibling = index;
+        }
+        prev = index;
+    }
+
+    doc->_charBuffer = 0;
+    doc->Clear();
+}
+
+
+unsigned XMLFrozenDocument::Offset( const char* str ) const
+{
+    return (unsigned)( str - _charBuffer );
+}
+
+
+unsigned XMLFrozenDocument::Add( const XMLNode* node, unsigned parent )
+{
+    const XMLElement* element = node->ToElement();
+    if ( !element && !node->ToText() ) {
+        return NONE;
+    }
+
+    unsigned index = _nodes.Size();
+    size_t length;
+    const char* value = node->Value( &length );
+    Node* n = _nodes.PushArr( 1 );
+    n->parent = parent;
+    n->firstChild = n->nextSibling = NONE;
+    n->value = Offset( value );
+    n->length = (unsigned)length;
+    n->firstAttribute = _attributes.Size();
+    n->attributeCount = 0;
+    n->tagId = (unsigned char)node->TagId();
+    n->type = element ? ELEMENT : TEXT;
+    if ( !element ) {
+        return index;
+    }
+
+    unsigned short count = 0;
+    for ( const XMLAttribute* a = element->FirstAttribute(); a; a = a->Next() ) {
+        Attribute* attribute = _attributes.PushArr( 1 );
+        attribute->name = Offset( a->Name() );
+        attribute->value = Offset( a->Value() );
+        attribute->nameId = a->NameId();
+        ++count;
+    }
+    _nodes[index].attributeCount = count;	// 'n' moves when the array grows
+
+    unsigned prev = NONE;
+    for ( const XMLNode* child = node->FirstChild(); child; child = child->NextSibling() ) {
+        unsigned childIndex = Add( child, index );
+        if ( childIndex == NONE ) {
+            continue;
+        }
+        if ( prev == NONE ) {
+            _nodes[index].firstChild = childIndex;
+        }
+        else {
+            _nodes[prev].nextSibling = childIndex;
+        }
+        prev = childIndex;
+    }
+    return index;
+}
+
+
+bool XMLFrozenDocument::Accept( unsigned index, XMLFrozenVisitor* visitor ) const
+{
+    const Node& node = _nodes[index];
+    if ( node.type == TEXT ) {
+        return visitor->Visit( XMLFrozenNode( this, index ) );
+    }
+    if ( node.type == ELEMENT && !visitor->VisitEnter( XMLFrozenNode( this, index ) ) ) {
+        return visitor->VisitExit( XMLFrozenNode( this, index ) );
+    }
+    for ( unsigned child = node.firstChild; child != NONE; child = _nodes[child].nextSibling ) {
+        if ( !Accept( child, visitor ) ) {
+            break;
+        }
+    }
+    if ( node.type == ELEMENT ) {
+        return visitor->VisitExit( XMLFrozenNode( this, index ) );
+    }
+    return true;
+}
+
+
+// --------- XMLFrozenNode ----------- //
+const char* XMLFrozenNode::AttributeById( int nameId ) const
+{
+    const XMLFrozenDocument::Node& node = Get();
+    for ( unsigned i = 0; i < node.attributeCount; ++i ) {
+        const XMLFrozenDocument::Attribute& a = _document->_attributes[node.firstAttribute + i];
+        if ( a.nameId == nameId ) {
+            return _document->_charBuffer + a.value;
+        }
+    }
+    return 0;
+}
+
+
+const char* XMLFrozenNode::Attribute( const char* name ) const
+{
+    const XMLFrozenDocument::Node& node = Get();
+    for ( unsigned i = 0; i < node.attributeCount; ++i ) {
+        const XMLFrozenDocument::Attribute& a = _document->_attributes[node.firstAttribute + i];
+        if ( XMLUtil::StringEqual( _document->_charBuffer + a.name, name ) ) {
+            return _document->_charBuffer + a.value;
+        }
+    }
+    return 0;
+}
+
+
+float XMLFrozenNode::FloatAttribute( const char* name ) const
+{
+    float f = 0;
+    const char* value = Attribute( name );
+    if ( value ) {
+        XMLUtil::ToFloat( value, &f );
+    }
+    return f;
+}
+
+
 XMLPrinter::XMLPrinter( FILE* file, bool compact, int depth ) :
     _elementJustOpened( false ),
     _firstElement( true ),
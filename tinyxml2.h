@@ -129,6 +129,7 @@ static const int TIXML2_PATCH_VERSION = 0;
 namespace tinyxml2
 {
 class XMLDocument;
+class XMLNode;
 class XMLElement;
 class XMLAttribute;
 class XMLComment;
@@ -170,6 +171,8 @@ public:
     }
 
     const char* GetStr();
+    // The same, also giving the length
+    const char* GetStr( size_t* length );
 
     bool Empty() const {
         return _start == _end;
@@ -320,14 +323,62 @@ public:
 };
 
 
+/*
+	Bump allocator for a whole document. Memory comes from large chunks
+	and is only given back all at once by Clear(), except that freeing the
+	most recent allocation takes it back, as parsing a closing tag does.
+*/
+class MemArena
+{
+public:
+    MemArena() : _chunk(0), _top(0), _end(0) {}
+    ~MemArena() {
+        Clear();
+    }
+
+    void* Alloc( int size ) {
+        size = ( size + ALIGN - 1 ) & ~( ALIGN - 1 );
+        if ( _end - _top < size ) {
+            NewChunk( size );
+        }
+        void* result = _top;
+        _top += size;
+        return result;
+    }
+    void Free( void* mem, int size ) {
+        size = ( size + ALIGN - 1 ) & ~( ALIGN - 1 );
+        if ( static_cast<char*>( mem ) + size == _top ) {
+            _top -= size;
+        }
+    }
+    void Clear();
+
+    enum { ALIGN = 8, CHUNK_SIZE = 1024*1024 };
+
+private:
+    MemArena( const MemArena& );	// not supported
+    void operator=( const MemArena& );	// not supported
+    void NewChunk( int size );
+
+    struct Chunk {
+        Chunk* next;
+        double align;
+    };
+    Chunk* _chunk;
+    char*  _top;
+    char*  _end;
+};
+
+
 /*
 	Template child class to create pools of the correct type.
+	With an arena set, items are allocated from the arena instead.
 */
 template< int SIZE >
 class MemPoolT : public MemPool
 {
 public:
-    MemPoolT() : _root(0), _currentAllocs(0), _nAllocs(0), _maxAllocs(0), _nUntracked(0)	{}
+    MemPoolT() : _root(0), _arena(0), _currentAllocs(0), _nAllocs(0), _maxAllocs(0), _nUntracked(0)	{}
     ~MemPoolT() {
         // Delete the blocks.
         for( int i=0; i<_blockPtrs.Size(); ++i ) {
@@ -342,7 +393,15 @@ public:
         return _currentAllocs;
     }
 
+    void SetArena( MemArena* arena ) {
+        _arena = arena;
+    }
+
     virtual void* Alloc() {
+        if ( _arena ) {
+            _nUntracked++;
+            return _arena->Alloc( SIZE );
+        }
         if ( !_root ) {
             // Need a new block.
             Block* block = new Block();
@@ -369,6 +428,10 @@ public:
         if ( !mem ) {
             return;
         }
+        if ( _arena ) {
+            _arena->Free( mem, SIZE );
+            return;
+        }
         --_currentAllocs;
         Chunk* chunk = static_cast<Chunk*>( mem );
 #ifdef DEBUG
@@ -411,6 +474,7 @@ private:
     };
     DynArray< Block*, 10 > _blockPtrs;
     Chunk* _root;
+    MemArena* _arena;
 
     int _currentAllocs;
     int _nAllocs;
@@ -481,6 +545,46 @@ public:
 };
 
 
+/**
+	Decides while a document is parsed which elements it keeps. Rejected
+	elements are left out of the document along with everything in them,
+	and their content is only scanned for the matching end tag, without
+	building nodes or checking it beyond that.
+
+	@sa XMLDocument::SetParseFilter()
+*/
+class TINYXML2_LIB XMLParseFilter
+{
+public:
+    virtual ~XMLParseFilter() {}
+
+    /** Called once the name and attributes of 'element' are parsed. The
+    	element is not linked yet, so its future parent is passed along.
+    	Return false to skip the element.
+    */
+    virtual bool Keep( const XMLNode& parent, const XMLElement& element ) = 0;
+};
+
+
+/*
+	Set of names known in advance, each identified by its index in the
+	array it was made from. Index 0 is never used so it can mean "other".
+*/
+class NameTable
+{
+public:
+    NameTable();
+    void Set( const char* const* names, int count );
+    int Lookup( const char* name, size_t length ) const;
+
+private:
+    // Open addressed hash of indices into _names
+    enum { SIZE = 512 };
+    const char* const* _names;
+    unsigned char _table[SIZE];
+};
+
+
 /*
 	Utility functionality.
 */
@@ -490,13 +594,13 @@ public:
     // Anything in the high order range of UTF-8 is assumed to not be whitespace. This isn't
     // correct, but simple, and usually works.
     static const char* SkipWhiteSpace( const char* p )	{
-        while( !IsUTF8Continuation(*p) && isspace( *reinterpret_cast<const unsigned char*>(p) ) ) {
+        while( IsWhiteSpace( *p ) ) {
             ++p;
         }
         return p;
     }
     static char* SkipWhiteSpace( char* p )				{
-        while( !IsUTF8Continuation(*p) && isspace( *reinterpret_cast<unsigned char*>(p) ) )		{
+        while( IsWhiteSpace( *p ) ) {
             ++p;
         }
         return p;
@@ -504,6 +608,11 @@ public:
     static bool IsWhiteSpace( char p )					{
         return !IsUTF8Continuation(p) && isspace( static_cast<unsigned char>(p) );
     }
+
+    // Buffers that documents are parsed in. They are aligned and padded with
+    // nulls so the scanners can read them in whole blocks.
+    static char* NewParseBuffer( size_t len );
+    static void DeleteParseBuffer( char* buffer );
     
     inline static bool IsNameStartChar( unsigned char ch ) {
         return ( ( ch < 128 ) ? isalpha( ch ) : 1 )
@@ -655,11 +764,25 @@ public:
     */
     const char* Value() const;
 
+    /** Value() along with its length. The value is a view into the parsed
+    	document; entities and line endings are only rewritten, in place,
+    	when the value contains any.
+    */
+    const char* Value( size_t* length ) const;
+
     /** Set the Value of an XML node.
     	@sa Value()
     */
     void SetValue( const char* val, bool staticMem=false );
 
+    /** For elements whose name is in the document's tag names, the index
+    	of the name. 0 for other elements and all other nodes.
+    	@sa XMLDocument::SetTagNames()
+    */
+    int TagId() const {
+        return _tagId;
+    }
+
     /// Get the parent of this node on the DOM.
     const XMLNode*	Parent() const			{
         return _parent;
@@ -837,6 +960,7 @@ protected:
     XMLDocument*	_document;
     XMLNode*		_parent;
     mutable StrPair	_value;
+    int				_tagId;
 
     XMLNode*		_firstChild;
     XMLNode*		_lastChild;
@@ -1040,6 +1164,13 @@ public:
 
     /// The value of the attribute.
     const char* Value() const;
+    /// The value of the attribute and its length. See XMLNode::Value( size_t* ).
+    const char* Value( size_t* length ) const;
+
+    /// Index of the name in the document's attribute names, 0 if it isn't one of them.
+    int NameId() const {
+        return _nameId;
+    }
 
     /// The next attribute in the list.
     const XMLAttribute* Next() const {
@@ -1110,19 +1241,21 @@ public:
 private:
     enum { BUF_SIZE = 200 };
 
-    XMLAttribute() : _next( 0 ), _memPool( 0 ) {}
+    XMLAttribute( XMLDocument* doc ) : _nameId( 0 ), _next( 0 ), _memPool( 0 ), _document( doc ) {}
     virtual ~XMLAttribute()	{}
 
     XMLAttribute( const XMLAttribute& );	// not supported
     void operator=( const XMLAttribute& );	// not supported
     void SetName( const char* name );
 
-    char* ParseDeep( char* p, bool processEntities );
+    char* ParseDeep( char* p, bool processEntities, const NameTable& names );
 
     mutable StrPair _name;
     mutable StrPair _value;
+    int             _nameId;
     XMLAttribute*   _next;
     MemPool*        _memPool;
+    XMLDocument*    _document;
 };
 
 
@@ -1346,6 +1479,16 @@ public:
     /// Query a specific attribute in the list.
     const XMLAttribute* FindAttribute( const char* name ) const;
 
+    /** Find the attribute with a name set with XMLDocument::SetAttributeNames()
+    	by its index. Compares integers rather than strings.
+    */
+    const XMLAttribute* FindAttributeById( int nameId ) const;
+    /// Value of the attribute found by FindAttributeById(), or null.
+    const char* AttributeById( int nameId ) const {
+        const XMLAttribute* a = FindAttributeById( nameId );
+        return a ? a->Value() : 0;
+    }
+
     /** Convenience function for easy access to the text inside an element. Although easy
     	and concise, GetText() is limited compared to getting the XMLText child
     	and accessing it directly.
@@ -1462,7 +1605,8 @@ public:
     enum {
         OPEN,		// <foo>
         CLOSED,		// <foo/>
-        CLOSING		// </foo>
+        CLOSING,	// </foo>
+        SKIPPED		// rejected by the XMLParseFilter
     };
     int ClosingType() const {
         return _closingType;
@@ -1481,6 +1625,7 @@ private:
     XMLAttribute* FindOrCreateAttribute( const char* name );
     //void LinkAttribute( XMLAttribute* attrib );
     char* ParseAttributes( char* p );
+    char* SkipContent( char* p );
     static void DeleteAttribute( XMLAttribute* attribute );
 
     enum { BUF_SIZE = 200 };
@@ -1505,7 +1650,10 @@ enum Whitespace {
 */
 class TINYXML2_LIB XMLDocument : public XMLNode
 {
+    friend class XMLNode;
     friend class XMLElement;
+    friend class XMLAttribute;
+    friend class XMLFrozenDocument;
 public:
     /// constructor
     XMLDocument( bool processEntities = true, Whitespace = PRESERVE_WHITESPACE );
@@ -1581,6 +1729,38 @@ public:
         _writeBOM = useBOM;
     }
 
+    /** Element names to recognize while parsing, so that elements can be
+    	told apart by XMLNode::TagId() instead of comparing names. Names
+    	are identified by their index in 'names', which must stay valid for
+    	the lifetime of the document. names[0] is unused, since 0 marks
+    	elements with other names. At most 255 names.
+    */
+    void SetTagNames( const char* const* names, int count ) {
+        _tagNames.Set( names, count );
+    }
+
+    /** Attribute names to recognize while parsing, identified like tag names.
+    	@sa XMLAttribute::NameId(), XMLElement::AttributeById()
+    */
+    void SetAttributeNames( const char* const* names, int count ) {
+        _attributeNames.Set( names, count );
+    }
+
+    /** Allocate all nodes and attributes of the document from a few large
+    	chunks. Unless the document was modified after parsing, Clear() and
+    	the destructor then release the DOM without visiting each node.
+    	Deleted nodes are only reclaimed when the document is cleared. Must
+    	be set while the document is empty.
+    */
+    void SetArena( bool arena );
+
+    /** Filter the elements of documents parsed from now on, or pass 0 to
+    	keep them all. The filter is not owned by the document.
+    */
+    void SetParseFilter( XMLParseFilter* filter ) {
+        _parseFilter = filter;
+    }
+
     /** Return the root element of DOM. Equivalent to FirstChildElement().
         To get the first node, use FirstChild().
     */
@@ -1698,14 +1878,216 @@ private:
     const char* _errorStr1;
     const char* _errorStr2;
     char*       _charBuffer;
+    bool        _arenaMode;
+    bool        _ownsStrings;	// a value was set after parsing, so nodes must be destroyed
+    XMLParseFilter* _parseFilter;
+    XMLNode*    _parseParent;	// node the element being parsed will be added to
+
+    void DeleteDOM();
+
+    NameTable   _tagNames;
+    NameTable   _attributeNames;
 
     MemPoolT< sizeof(XMLElement) >	 _elementPool;
     MemPoolT< sizeof(XMLAttribute) > _attributePool;
     MemPoolT< sizeof(XMLText) >		 _textPool;
     MemPoolT< sizeof(XMLComment) >	 _commentPool;
+    MemArena                         _arena;
+};
+
+
+class XMLFrozenNode;
+
+/**
+	Implements the visitor pattern for an XMLFrozenDocument. Elements are
+	visited with a VisitEnter/VisitExit pair and text with Visit(). As with
+	XMLVisitor, returning false from VisitEnter skips the children of the
+	element, and returning false otherwise stops visiting its siblings.
+*/
+class TINYXML2_LIB XMLFrozenVisitor
+{
+public:
+    virtual ~XMLFrozenVisitor() {}
+
+    /// Visit an element.
+    virtual bool VisitEnter( const XMLFrozenNode& /*element*/ )	{
+        return true;
+    }
+    /// Visit an element.
+    virtual bool VisitExit( const XMLFrozenNode& /*element*/ )		{
+        return true;
+    }
+    /// Visit a text node.
+    virtual bool Visit( const XMLFrozenNode& /*text*/ )			{
+        return true;
+    }
 };
 
 
+/**
+	A read-only copy of a parsed document in a compact layout. Nodes are
+	stored in document order in one array and refer to their parent, first
+	child and next sibling by 32-bit index. Each keeps its tag ID and the
+	span of its name or text in the character buffer, which is taken over
+	from the XMLDocument. Attributes are stored the same way in a second
+	array.
+
+	Walking a frozen document touches a fraction of the memory of the
+	pointer linked DOM. Only elements and text are kept; comments,
+	declarations and unknown nodes are dropped.
+
+	Nodes are accessed through XMLFrozenNode handles:
+	@verbatim
+	XMLFrozenDocument frozen;
+	frozen.Freeze( &doc );
+	frozen.Document().Accept( &visitor );
+	@endverbatim
+*/
+class TINYXML2_LIB XMLFrozenDocument
+{
+    friend class XMLFrozenNode;
+public:
+    XMLFrozenDocument() : _charBuffer( 0 ) {}
+    ~XMLFrozenDocument() {
+        XMLUtil::DeleteParseBuffer( _charBuffer );
+    }
+
+    /** Copy the structure of 'doc', which must have been parsed and not
+    	modified since, and take over its character buffer. 'doc' is cleared.
+    */
+    void Freeze( XMLDocument* doc );
+
+    /// The node standing for the document itself, parent of the root element.
+    XMLFrozenNode Document() const;
+
+    /// Number of nodes, including the document node.
+    int NodeCount() const {
+        return _nodes.Size();
+    }
+
+private:
+    XMLFrozenDocument( const XMLFrozenDocument& );	// not supported
+    void operator=( const XMLFrozenDocument& );	// not supported
+
+    enum { NONE = 0xffffffff };
+    enum { DOCUMENT, ELEMENT, TEXT };
+
+    struct Node {
+        unsigned       parent;
+        unsigned       firstChild;
+        unsigned       nextSibling;
+        unsigned       value;		// offset of the name or text in the character buffer
+        unsigned       length;
+        unsigned       firstAttribute;
+        unsigned short attributeCount;
+        unsigned char  tagId;
+        unsigned char  type;
+    };
+    struct Attribute {
+        unsigned name;
+        unsigned value;
+        int      nameId;
+    };
+
+    unsigned Add( const XMLNode* node, unsigned parent );
+    unsigned Offset( const char* str ) const;
+    bool Accept( unsigned index, XMLFrozenVisitor* visitor ) const;
+
+    DynArray< Node, 1 >      _nodes;
+    DynArray< Attribute, 1 > _attributes;
+    char*                    _charBuffer;
+};
+
+
+/**
+	A handle to a node of an XMLFrozenDocument, passed by value. A null
+	handle is returned where XMLNode would return a null pointer.
+*/
+class TINYXML2_LIB XMLFrozenNode
+{
+    friend class XMLFrozenDocument;
+public:
+    XMLFrozenNode() : _document( 0 ), _index( XMLFrozenDocument::NONE ) {}
+
+    bool IsNull() const {
+        return _index == XMLFrozenDocument::NONE;
+    }
+    bool IsDocument() const {
+        return !IsNull() && Get().type == XMLFrozenDocument::DOCUMENT;
+    }
+    bool IsElement() const {
+        return !IsNull() && Get().type == XMLFrozenDocument::ELEMENT;
+    }
+    bool IsText() const {
+        return !IsNull() && Get().type == XMLFrozenDocument::TEXT;
+    }
+
+    /// Position of the node in document order, 0 being the document.
+    unsigned Index() const {
+        return _index;
+    }
+
+    /// @sa XMLNode::TagId()
+    int TagId() const {
+        return Get().tagId;
+    }
+
+    /// The name of an element or the text of a text node.
+    const char* Value() const {
+        return _document->_charBuffer + Get().value;
+    }
+    const char* Value( size_t* length ) const {
+        *length = Get().length;
+        return Value();
+    }
+
+    XMLFrozenNode Parent() const {
+        return XMLFrozenNode( _document, Get().parent );
+    }
+    XMLFrozenNode FirstChild() const {
+        return XMLFrozenNode( _document, Get().firstChild );
+    }
+    XMLFrozenNode NextSibling() const {
+        return XMLFrozenNode( _document, Get().nextSibling );
+    }
+
+    /// @sa XMLElement::AttributeById()
+    const char* AttributeById( int nameId ) const;
+    /// @sa XMLElement::Attribute()
+    const char* Attribute( const char* name ) const;
+    /// @sa XMLElement::FloatAttribute()
+    float FloatAttribute( const char* name ) const;
+
+    /// Visit this node and its descendants. The document node only visits its children.
+    bool Accept( XMLFrozenVisitor* visitor ) const {
+        return _document->Accept( _index, visitor );
+    }
+
+    bool operator==( const XMLFrozenNode& node ) const {
+        return _index == node._index && _document == node._document;
+    }
+    bool operator!=( const XMLFrozenNode& node ) const {
+        return !( *this == node );
+    }
+
+private:
+    XMLFrozenNode( const XMLFrozenDocument* document, unsigned index ) : _document( document ), _index( index ) {}
+
+    const XMLFrozenDocument::Node& Get() const {
+        return _document->_nodes[_index];
+    }
+
+    const XMLFrozenDocument* _document;
+    unsigned                 _index;
+};
+
+
+inline XMLFrozenNode XMLFrozenDocument::Document() const
+{
+    return XMLFrozenNode( this, _nodes.Empty() ? (unsigned)NONE : 0 );
+}
+
+
 /**
 	A XMLHandle is a class that wraps a node pointer with null checks; this is
 	an incredibly useful thing. Note that XMLHandle is not part of the TinyXML-2
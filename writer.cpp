@@ -0,0 +1,89 @@
+#include <stdio.h>
+
+#include "writer.h"
+
+namespace glbindify {
+
+void writer::vprint(const char *format, va_list args)
+{
+	va_list args_copy;
+	va_copy(args_copy, args);
+	size_t pos = m_out.size();
+	m_out.resize(pos + 256);
+	int len = vsnprintf(&m_out[pos], 256, format, args);
+	if (len >= 256) {
+		m_out.resize(pos + len + 1);
+		vsnprintf(&m_out[pos], len + 1, format, args_copy);
+	}
+	va_end(args_copy);
+	m_out.resize(pos + (len > 0 ? len : 0));
+	written();
+}
+
+void writer::print(const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	vprint(format, args);
+	va_end(args);
+}
+
+void writer::indent_print(const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	m_out += m_indent_string;
+	vprint(format, args);
+	va_end(args);
+}
+
+writer &writer::write_int(int value)
+{
+	char buf[16];
+	char *p = buf + sizeof(buf);
+	unsigned int u = value < 0 ? 0u - (unsigned int)value : value;
+	do {
+		*--p = '0' + u % 10;
+		u /= 10;
+	} while (u);
+	if (value < 0)
+		*--p = '-';
+	return write(p, buf + sizeof(buf) - p);
+}
+
+writer &writer::write_hex(uint64_t value)
+{
+	static const char digits[] = "0123456789abcdef";
+	char buf[16];
+	char *p = buf + sizeof(buf);
+	do {
+		*--p = digits[value & 0xf];
+		value >>= 4;
+	} while (value);
+	return write(p, buf + sizeof(buf) - p);
+}
+
+void writer::flush()
+{
+	if (m_out.size())
+		m_sink.write(m_out.data(), m_out.size());
+	m_out.clear();
+}
+
+void writer::increase_indent()
+{
+	m_indent_string.push_back('\t');
+}
+
+void writer::decrease_indent()
+{
+	if (m_indent_string.size() > 0)
+		m_indent_string.resize(m_indent_string.size() -1);
+}
+
+void writer::reset_indent()
+{
+	m_indent_string.clear();
+}
+
+}
@@ -0,0 +1,59 @@
+#ifndef GLBINDIFY_WRITER_H
+#define GLBINDIFY_WRITER_H
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+
+#include "glbindify.h"
+
+namespace glbindify {
+
+//
+//Formatting into an output sink with tracking of the current indentation
+//level. Output is collected in a buffer that is handed to the sink in large
+//pieces, so anything writing to the sink directly must flush() first.
+//
+class writer {
+	output_sink &m_sink;
+	std::string m_indent_string;
+	std::string m_out;
+
+	void written()
+	{
+		if (m_out.size() >= 64 * 1024)
+			flush();
+	}
+public:
+	writer(output_sink &sink) : m_sink(sink) {}
+	~writer() { flush(); }
+
+	void vprint(const char *format, va_list args);
+	void print(const char *format, ...);
+	void indent_print(const char *format, ...);
+
+	//
+	//Unformatted output, for the parts of the bindings that are repeated
+	//often enough for parsing a format string to show
+	//
+	writer &write(const char *data, size_t size) { m_out.append(data, size); written(); return *this; }
+	writer &write(const char *str) { return write(str, strlen(str)); }
+	writer &write(const std::string &str) { return write(str.data(), str.size()); }
+	writer &write(char c) { m_out.push_back(c); return *this; }
+	writer &write_int(int value);
+	writer &write_hex(uint64_t value);
+	writer &indent() { return write(m_indent_string); }
+
+	//Hand everything written so far to the sink
+	void flush();
+
+	void increase_indent();
+	void decrease_indent();
+	void reset_indent();
+};
+
+}
+
+#endif